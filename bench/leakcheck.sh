@@ -0,0 +1,104 @@
+#!/bin/sh
+#
+# Run qtwm against a private Xvfb through a long scripted session, and
+# fail if it holds on to more after the session than after warming up.
+#
+# Warm-up rounds let the pools, tables and malloc arenas grow to what
+# the session needs. After that, every round leaves no windows behind,
+# so nothing qtwm allocates for them should still be live: the live
+# counts of events, replies and clients have to be back where they were,
+# and heap and RSS may only grow by a little slack.
+#
+# Usage: bench/leakcheck.sh [rounds]
+
+set -e
+
+QTWM=${QTWM:-./qtwm}
+BENCH=${BENCH:-./qtwm_bench}
+WARMUP=${WARMUP:-3}
+ROUNDS=${1:-30}
+# Allowed growth after warm-up
+HEAP_SLACK=${HEAP_SLACK:-65536}
+RSS_SLACK_KB=${RSS_SLACK_KB:-512}
+
+DISPLAY_FILE=$(mktemp)
+BEFORE=$(mktemp)
+AFTER=$(mktemp)
+Xvfb -displayfd 3 -screen 0 1920x1080x24 -nolisten tcp 3>"$DISPLAY_FILE" 2>/dev/null &
+XVFB_PID=$!
+trap 'kill $QTWM_PID $XVFB_PID 2>/dev/null; rm -f "$DISPLAY_FILE" "$BEFORE" "$AFTER"' EXIT
+
+while [ ! -s "$DISPLAY_FILE" ]; do
+    sleep 0.05
+done
+DISPLAY=:$(cat "$DISPLAY_FILE")
+export DISPLAY
+# Must match STATS_FILE in src/config.h and ipc_dir() in src/ipc.h
+case "$XDG_RUNTIME_DIR" in
+/*) STATS_DIR=$XDG_RUNTIME_DIR ;;
+*) STATS_DIR=/tmp/qtwm-$(id -u) ;;
+esac
+STATS_FILE=${STATS_FILE:-$STATS_DIR/qtwm$DISPLAY.stats}
+
+"$QTWM" 2>/dev/null &
+QTWM_PID=$!
+sleep 0.2
+
+# One of everything the benchmarks do. Each client's windows go away
+# when it disconnects.
+round() {
+    for scenario in "map 50" "destroy 50" "move 500" "resize 500" "focus 50" "relayout 50" "workspace 10"; do
+        # shellcheck disable=SC2086
+        "$BENCH" $scenario >/dev/null
+    done
+    # Make sure the last DestroyNotify has been handled
+    "$BENCH" poke >/dev/null
+}
+
+# file
+dump_stats() {
+    rm -f "$STATS_FILE"
+    kill -USR1 $QTWM_PID
+    while [ ! -s "$STATS_FILE" ]; do
+        sleep 0.05
+    done
+    # Written by a single fprintf() per line; wait for the last one
+    while ! grep -q '^rss_kb ' "$STATS_FILE"; do
+        sleep 0.05
+    done
+    grep -E '^(mem_[a-z]+ |heap_bytes |rss_kb )' "$STATS_FILE" > "$1"
+}
+
+i=0
+while [ $i -lt "$WARMUP" ]; do
+    round
+    i=$((i + 1))
+done
+dump_stats "$BEFORE"
+
+i=0
+while [ $i -lt "$ROUNDS" ]; do
+    round
+    i=$((i + 1))
+done
+dump_stats "$AFTER"
+
+echo "== after $WARMUP warm-up rounds"
+cat "$BEFORE"
+echo "== after $ROUNDS more"
+cat "$AFTER"
+
+# Compare the two dumps line by line
+awk -v heap_slack="$HEAP_SLACK" -v rss_slack="$RSS_SLACK_KB" '
+    NR == FNR { before[$1] = $1 ~ /^mem_/ ? $3 : $2; next }
+    $1 ~ /^mem_/ && $3 > before[$1] {
+        printf "LEAK: %s live went from %s to %s\n", $1, before[$1], $3; bad = 1
+    }
+    $1 == "heap_bytes" && $2 - before[$1] > heap_slack {
+        printf "LEAK: heap grew by %d bytes\n", $2 - before[$1]; bad = 1
+    }
+    $1 == "rss_kb" && $2 - before[$1] > rss_slack {
+        printf "LEAK: RSS grew by %d kB\n", $2 - before[$1]; bad = 1
+    }
+    END { if(!bad) print "no growth"; exit bad }
+' "$BEFORE" "$AFTER"
@@ -0,0 +1,345 @@
+/*
+ * Synthetic X clients for benchmarking qtwm.
+ *
+ * Each scenario drives qtwm through an ordinary client connection (and
+ * XTEST for pointer and keyboard input), then prints how long the
+ * client saw it take. qtwm's own view comes from its statistics dump;
+ * see bench/run.sh.
+ *
+ * Usage: qtwm_bench <map|destroy|move|resize|focus|relayout|workspace|poke> [count]
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <xcb/xcb.h>
+#include <xcb/xtest.h>
+
+#include "config.h"
+#include "ipc.h"
+
+/* Keysyms for the modifiers in MODIFIER_MASK */
+#define XK_Shift_L 0xffe1
+#define XK_Alt_L 0xffe9
+
+xcb_connection_t* dpy;
+xcb_screen_t* screen;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/*
+ * Wait until the server has handled everything we sent.
+ */
+static void sync_server(void) {
+    free(xcb_get_input_focus_reply(dpy, xcb_get_input_focus(dpy), NULL));
+}
+
+static xcb_window_t make_window(int16_t x, int16_t y, uint16_t w, uint16_t h) {
+    xcb_window_t window = xcb_generate_id(dpy);
+    uint32_t values[2] = { screen->white_pixel, XCB_EVENT_MASK_STRUCTURE_NOTIFY };
+
+    xcb_create_window(dpy, XCB_COPY_FROM_PARENT, window, screen->root, x, y, w, h, 0,
+                      XCB_WINDOW_CLASS_INPUT_OUTPUT, screen->root_visual,
+                      XCB_CW_BACK_PIXEL | XCB_CW_EVENT_MASK, values);
+    return window;
+}
+
+/*
+ * Wait for count events of type.
+ */
+static void wait_for(uint8_t type, uint32_t count) {
+    xcb_generic_event_t* ev;
+
+    while(count > 0 && (ev = xcb_wait_for_event(dpy)) != NULL) {
+        if((ev->response_type & ~0x80) == type) {
+            count--;
+        }
+        free(ev);
+    }
+}
+
+static xcb_window_t* map_storm(uint32_t n) {
+    xcb_window_t* windows = malloc(n * sizeof(xcb_window_t));
+
+    for(uint32_t i = 0; i < n; i++) {
+        windows[i] = make_window((i * 37) % 1600, (i * 23) % 900, 200, 150);
+        xcb_map_window(dpy, windows[i]);
+    }
+    xcb_flush(dpy);
+    wait_for(XCB_MAP_NOTIFY, n);
+
+    return windows;
+}
+
+static xcb_keycode_t keycode_for(xcb_keysym_t keysym) {
+    const xcb_setup_t* setup = xcb_get_setup(dpy);
+    xcb_get_keyboard_mapping_reply_t* map;
+    xcb_keysym_t* syms;
+    xcb_keycode_t found = 0;
+    uint8_t count = setup->max_keycode - setup->min_keycode + 1;
+
+    map = xcb_get_keyboard_mapping_reply(dpy, xcb_get_keyboard_mapping(dpy, setup->min_keycode, count), NULL);
+    if(map == NULL) {
+        return 0;
+    }
+    syms = xcb_get_keyboard_mapping_keysyms(map);
+    for(int i = 0; i < xcb_get_keyboard_mapping_keysyms_length(map) && !found; i++) {
+        if(syms[i] == keysym) {
+            found = setup->min_keycode + i / map->keysyms_per_keycode;
+        }
+    }
+    free(map);
+
+    return found;
+}
+
+static void fake(uint8_t type, uint8_t detail, int16_t x, int16_t y) {
+    xcb_test_fake_input(dpy, type, detail, XCB_CURRENT_TIME, screen->root, x, y, 0);
+}
+
+/*
+ * Hold the qtwm modifiers and drag with button from (x, y) in steps
+ * pixels to the lower right, one motion event per pixel.
+ */
+static void drag(uint8_t button, int16_t x, int16_t y, uint32_t steps) {
+    xcb_keycode_t shift = keycode_for(XK_Shift_L);
+    xcb_keycode_t alt = keycode_for(XK_Alt_L);
+
+    fake(XCB_MOTION_NOTIFY, 0, x, y);
+    fake(XCB_KEY_PRESS, alt, 0, 0);
+    fake(XCB_KEY_PRESS, shift, 0, 0);
+    fake(XCB_BUTTON_PRESS, button, 0, 0);
+    sync_server();
+    for(uint32_t i = 1; i <= steps; i++) {
+        fake(XCB_MOTION_NOTIFY, 0, x + i % 600, y + i % 400);
+        if(i % 64 == 0) {
+            xcb_flush(dpy);
+        }
+    }
+    fake(XCB_BUTTON_RELEASE, button, 0, 0);
+    fake(XCB_KEY_RELEASE, shift, 0, 0);
+    fake(XCB_KEY_RELEASE, alt, 0, 0);
+    sync_server();
+}
+
+/*
+ * Connect to qtwm's control socket. Returns -1 on error.
+ */
+static int control_connect(void) {
+    struct sockaddr_un addr;
+    const char* display = getenv("DISPLAY");
+    char dir[96];
+    int fd;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), IPC_SOCKET, ipc_dir(dir, sizeof(dir)), display ? display : "");
+    fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    if(fd < 0 || connect(fd, (struct sockaddr*) &addr, sizeof(addr)) != 0) {
+        perror("qtwm_bench: control socket");
+        if(fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+
+    return fd;
+}
+
+/*
+ * Send count commands as one request. Returns how many qtwm carried
+ * out, or 0 on error.
+ */
+static uint32_t control(int fd, const struct ipc_command* cmds, uint32_t count) {
+    struct ipc_reply reply;
+
+    if(send(fd, cmds, count * sizeof(struct ipc_command), 0) < 0
+            || recv(fd, &reply, sizeof(reply), MSG_TRUNC) < (ssize_t) sizeof(reply)) {
+        perror("qtwm_bench: control request");
+        return 0;
+    }
+
+    return reply.done;
+}
+
+/*
+ * Tile windows into a grid through qtwm's control socket, as few
+ * requests as it takes. Returns false if qtwm didn't do all of it.
+ */
+static bool relayout(const xcb_window_t* windows, uint32_t n) {
+    struct ipc_command* cmds = calloc(IPC_MAX_COMMANDS, sizeof(struct ipc_command));
+    uint32_t cols = 1;
+    uint32_t done = 0;
+    int fd = control_connect();
+
+    while(cols * cols < n) {
+        cols++;
+    }
+    if(cmds == NULL || fd < 0) {
+        free(cmds);
+        return false;
+    }
+
+    for(uint32_t i = 0; i < n; i += IPC_MAX_COMMANDS) {
+        uint32_t count = n - i < IPC_MAX_COMMANDS ? n - i : IPC_MAX_COMMANDS;
+
+        for(uint32_t j = 0; j < count; j++) {
+            uint32_t k = i + j;
+
+            cmds[j].op = IPC_MOVE_RESIZE;
+            cmds[j].window = windows[k];
+            cmds[j].x = (int16_t) ((k % cols) * (screen->width_in_pixels / cols));
+            cmds[j].y = (int16_t) ((k / cols) * (screen->height_in_pixels / cols));
+            // Odd sizes, so every window really changes
+            cmds[j].w = (uint16_t) ((screen->width_in_pixels / cols) | 1);
+            cmds[j].h = (uint16_t) ((screen->height_in_pixels / cols) | 1);
+        }
+        done += control(fd, cmds, count);
+    }
+    close(fd);
+    free(cmds);
+
+    return done == n;
+}
+
+/*
+ * Put n windows on each of two workspaces, then flip between them
+ * switches times, noting in start when the flipping began. Returns
+ * false if qtwm didn't do all of it.
+ */
+static bool flip_workspaces(uint32_t n, uint32_t switches, uint64_t* start) {
+    struct ipc_command* cmds = calloc(n, sizeof(struct ipc_command));
+    xcb_window_t* windows = map_storm(n);
+    uint32_t done = 0;
+    int fd = control_connect();
+
+    if(cmds == NULL || fd < 0) {
+        free(cmds);
+        free(windows);
+        return false;
+    }
+    for(uint32_t i = 0; i < n; i++) {
+        cmds[i].op = IPC_SEND_TO_WORKSPACE;
+        cmds[i].window = windows[i];
+        cmds[i].x = 1;
+    }
+    control(fd, cmds, n);
+    wait_for(XCB_UNMAP_NOTIFY, n);
+    free(windows);
+    free(map_storm(n));
+
+    *start = now_ns();
+    for(uint32_t i = 0; i < switches; i++) {
+        struct ipc_command cmd = { .op = IPC_WORKSPACE, .x = (int16_t) ((i + 1) % 2) };
+
+        done += control(fd, &cmd, 1);
+    }
+    sync_server();
+    close(fd);
+    free(cmds);
+
+    return done == switches;
+}
+
+int main(int argc, char** argv) {
+    const char* scenario;
+    uint32_t n;
+    uint64_t start;
+    xcb_window_t* windows;
+
+    if(argc < 2) {
+        fprintf(stderr, "usage: %s <map|destroy|move|resize|focus|relayout|workspace|poke> [count]\n", argv[0]);
+        return 2;
+    }
+    scenario = argv[1];
+    n = argc > 2 ? (uint32_t) strtoul(argv[2], NULL, 10) : 100;
+
+    dpy = xcb_connect(NULL, NULL);
+    if(xcb_connection_has_error(dpy)) {
+        fprintf(stderr, "Error connecting to X display!\n");
+        return 1;
+    }
+    screen = xcb_setup_roots_iterator(xcb_get_setup(dpy)).data;
+
+    start = now_ns();
+    if(strcmp(scenario, "map") == 0) {
+        // N windows mapped at once, until the last one is on screen
+        map_storm(n);
+    } else if(strcmp(scenario, "destroy") == 0) {
+        // N mapped windows destroyed at once
+        windows = map_storm(n);
+        start = now_ns();
+        for(uint32_t i = 0; i < n; i++) {
+            xcb_destroy_window(dpy, windows[i]);
+        }
+        xcb_flush(dpy);
+        wait_for(XCB_DESTROY_NOTIFY, n);
+        free(windows);
+    } else if(strcmp(scenario, "move") == 0 || strcmp(scenario, "resize") == 0) {
+        // One window dragged through N pointer positions
+        windows = map_storm(1);
+        start = now_ns();
+        drag(strcmp(scenario, "move") == 0 ? MOVE_MOUSE_BUTTON : RESIZE_MOUSE_BUTTON, 100, 100, n);
+        free(windows);
+    } else if(strcmp(scenario, "focus") == 0) {
+        // Pointer swept back and forth across a row of N windows
+        windows = malloc(n * sizeof(xcb_window_t));
+        for(uint32_t i = 0; i < n; i++) {
+            windows[i] = make_window((i % 32) * 60, (i / 32) * 60, 50, 50);
+            xcb_map_window(dpy, windows[i]);
+        }
+        xcb_flush(dpy);
+        wait_for(XCB_MAP_NOTIFY, n);
+        start = now_ns();
+        for(uint32_t sweep = 0; sweep < 10; sweep++) {
+            for(uint32_t i = 0; i < n; i++) {
+                uint32_t j = sweep % 2 ? n - 1 - i : i;
+
+                xcb_warp_pointer(dpy, XCB_NONE, screen->root, 0, 0, 0, 0,
+                                 (j % 32) * 60 + 25, (j / 32) * 60 + 25);
+            }
+            xcb_flush(dpy);
+        }
+        sync_server();
+        free(windows);
+    } else if(strcmp(scenario, "relayout") == 0) {
+        // N windows tiled through the control socket, until the last
+        // one has its new geometry
+        windows = map_storm(n);
+        start = now_ns();
+        if(relayout(windows, n)) {
+            wait_for(XCB_CONFIGURE_NOTIFY, n);
+        } else {
+            fprintf(stderr, "qtwm didn't move every window!\n");
+        }
+        free(windows);
+    } else if(strcmp(scenario, "workspace") == 0) {
+        // 100 switches between two workspaces of N windows each
+        if(!flip_workspaces(n, 100, &start)) {
+            fprintf(stderr, "qtwm didn't switch every time!\n");
+        }
+    } else if(strcmp(scenario, "poke") == 0) {
+        // Just wake qtwm up
+        xcb_destroy_window(dpy, make_window(0, 0, 1, 1));
+        sync_server();
+    } else {
+        fprintf(stderr, "Unknown scenario %s\n", scenario);
+        xcb_disconnect(dpy);
+        return 2;
+    }
+    printf("client_ms %.3f\n", (now_ns() - start) / 1e6);
+
+    xcb_disconnect(dpy);
+    return 0;
+}
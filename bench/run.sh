@@ -0,0 +1,63 @@
+#!/bin/sh
+#
+# Run qtwm against a private Xvfb and drive it through each benchmark
+# scenario. qtwm is restarted for every scenario so its statistics
+# only cover that scenario.
+#
+# Usage: bench/run.sh [count]
+
+set -e
+
+QTWM=${QTWM:-./qtwm}
+BENCH=${BENCH:-./qtwm_bench}
+COUNT=${1:-200}
+
+DISPLAY_FILE=$(mktemp)
+Xvfb -displayfd 3 -screen 0 1920x1080x24 -nolisten tcp 3>"$DISPLAY_FILE" 2>/dev/null &
+XVFB_PID=$!
+trap 'kill $XVFB_PID 2>/dev/null; rm -f "$DISPLAY_FILE"' EXIT
+
+while [ ! -s "$DISPLAY_FILE" ]; do
+    sleep 0.05
+done
+DISPLAY=:$(cat "$DISPLAY_FILE")
+export DISPLAY
+# Must match STATS_FILE in src/config.h and ipc_dir() in src/ipc.h
+case "$XDG_RUNTIME_DIR" in
+/*) STATS_DIR=$XDG_RUNTIME_DIR ;;
+*) STATS_DIR=/tmp/qtwm-$(id -u) ;;
+esac
+STATS_FILE=${STATS_FILE:-$STATS_DIR/qtwm$DISPLAY.stats}
+
+# scenario count
+run_scenario() {
+    rm -f "$STATS_FILE"
+    "$QTWM" 2>/dev/null &
+    QTWM_PID=$!
+    sleep 0.2
+
+    CLIENT_MS=$("$BENCH" "$1" "$2" | awk '/^client_ms/ { print $2 }')
+
+    kill -USR1 $QTWM_PID
+    while [ ! -s "$STATS_FILE" ]; do
+        sleep 0.05
+    done
+    RSS_KB=$(awk '/^VmRSS/ { print $2 }' /proc/$QTWM_PID/status)
+    kill $QTWM_PID
+    wait $QTWM_PID 2>/dev/null || true
+
+    echo "== $1 $2"
+    echo "client_ms $CLIENT_MS"
+    echo "rss_kb $RSS_KB"
+    grep -E '^(events|batches|flushes|requests|roundtrips) ' "$STATS_FILE"
+    # Per event type: count, p50 and p99 handling latency
+    awk '$2 == "count" { printf "%-18s n %-8s p50_us %-6s p99_us %-6s max_us %s\n", $1, $3, $7, $9, $11 }' "$STATS_FILE"
+}
+
+run_scenario map "$COUNT"
+run_scenario destroy "$COUNT"
+run_scenario move $((COUNT * 10))
+run_scenario resize $((COUNT * 10))
+run_scenario focus "$COUNT"
+run_scenario relayout "$COUNT"
+run_scenario workspace 40
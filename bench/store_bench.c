@@ -0,0 +1,138 @@
+/*
+ * Whole-desktop geometry queries: client store vs. winlist.
+ *
+ * The list side mirrors how clients used to be kept: one malloc'd
+ * struct per window with geometry inline, reached through
+ * struct item->data, allocated in random order like a long-running
+ * session would.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "list.h"
+#include "store.h"
+
+#define SCREEN_W 3840
+#define SCREEN_H 2160
+/* Total queries per measurement, split over the repetitions */
+#define QUERIES 2000000
+
+struct list_client {
+    xcb_window_t id;
+    int16_t x;
+    int16_t y;
+    uint16_t w;
+    uint16_t h;
+};
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/*
+ * Same rule as store_at(): stop at the first window holding the point,
+ * in whatever order the container keeps them.
+ */
+static xcb_window_t list_at(struct item* list, int16_t px, int16_t py) {
+    for(struct item* item = list; item != NULL; item = item->next) {
+        struct list_client* c = item->data;
+
+        if((uint32_t) (px - c->x) < c->w && (uint32_t) (py - c->y) < c->h) {
+            return c->id;
+        }
+    }
+
+    return XCB_NONE;
+}
+
+static uint32_t list_count_overlapping(struct item* list, xcb_rectangle_t rect) {
+    uint32_t n = 0;
+
+    for(struct item* item = list; item != NULL; item = item->next) {
+        struct list_client* c = item->data;
+
+        n += c->x < rect.x + rect.width && rect.x < c->x + c->w
+             && c->y < rect.y + rect.height && rect.y < c->y + c->h;
+    }
+
+    return n;
+}
+
+static void run(uint32_t n) {
+    struct item* list = NULL;
+    struct store store = STORE_INIT;
+    struct list_client** clients;
+    uint32_t rounds = QUERIES / n < 100 ? 100 : QUERIES / n;
+    uint64_t start, list_at_ns, store_at_ns, list_rect_ns, store_rect_ns;
+    volatile uint64_t sink = 0;
+    xcb_rectangle_t rect = { SCREEN_W / 4, SCREEN_H / 4, SCREEN_W / 2, SCREEN_H / 2 };
+
+    clients = malloc(n * sizeof(*clients));
+    for(uint32_t i = 0; i < n; i++) {
+        clients[i] = malloc(sizeof(struct list_client));
+        clients[i]->id = 0x400000 + i;
+        clients[i]->x = rand() % SCREEN_W;
+        clients[i]->y = rand() % SCREEN_H;
+        clients[i]->w = 64 + rand() % 800;
+        clients[i]->h = 64 + rand() % 600;
+        store_add(&store, clients[i]->id, clients[i]->x, clients[i]->y, clients[i]->w, clients[i]->h);
+    }
+    // Link in a shuffled order so the list isn't walking the heap linearly
+    for(uint32_t i = n; i > 1; i--) {
+        uint32_t j = rand() % i;
+        struct list_client* tmp = clients[i - 1];
+
+        clients[i - 1] = clients[j];
+        clients[j] = tmp;
+    }
+    for(uint32_t i = 0; i < n; i++) {
+        additem(&list)->data = clients[i];
+    }
+
+    start = now_ns();
+    for(uint32_t r = 0; r < rounds; r++) {
+        sink += list_at(list, r % SCREEN_W, (r * 7) % SCREEN_H);
+    }
+    list_at_ns = now_ns() - start;
+
+    start = now_ns();
+    for(uint32_t r = 0; r < rounds; r++) {
+        sink += store_at(&store, r % SCREEN_W, (r * 7) % SCREEN_H);
+    }
+    store_at_ns = now_ns() - start;
+
+    start = now_ns();
+    for(uint32_t r = 0; r < rounds; r++) {
+        rect.x = r % (SCREEN_W / 2);
+        sink += list_count_overlapping(list, rect);
+    }
+    list_rect_ns = now_ns() - start;
+
+    start = now_ns();
+    for(uint32_t r = 0; r < rounds; r++) {
+        rect.x = r % (SCREEN_W / 2);
+        sink += store_count_overlapping(&store, rect);
+    }
+    store_rect_ns = now_ns() - start;
+
+    printf("%6u clients  point: list %9.1f ns  store %9.1f ns  |  rect: list %9.1f ns  store %9.1f ns\n",
+           n, (double) list_at_ns / rounds, (double) store_at_ns / rounds,
+           (double) list_rect_ns / rounds, (double) store_rect_ns / rounds);
+
+    delallitems(&list, NULL);
+    free(clients);
+    store_free(&store);
+}
+
+int main(void) {
+    srand(1);
+    run(10);
+    run(100);
+    run(10000);
+    return 0;
+}
@@ -0,0 +1,65 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <xcb/xcbext.h>
+
+#include "async.h"
+#include "stats.h"
+
+bool async_push(struct async_queue* queue, xcb_connection_t* dpy,
+                unsigned int sequence, async_cb cb, void* data) {
+    if(queue->len == queue->cap) {
+        size_t cap = queue->cap ? queue->cap * 2 : 64;
+        struct async_req* reqs = realloc(queue->reqs, cap * sizeof(struct async_req));
+
+        if(reqs == NULL) {
+            xcb_discard_reply(dpy, sequence);
+            return false;
+        }
+        queue->reqs = reqs;
+        queue->cap = cap;
+    }
+
+    queue->reqs[queue->len].sequence = sequence;
+    queue->reqs[queue->len].cb = cb;
+    queue->reqs[queue->len].data = data;
+    queue->len++;
+
+    return true;
+}
+
+void async_resolve(struct async_queue* queue, xcb_connection_t* dpy) {
+    size_t n = queue->len;
+
+    if(n == 0) {
+        return;
+    }
+    stats.roundtrips++;
+
+    // The first wait flushes and blocks; the rest are already here.
+    for(size_t i = 0; i < n; i++) {
+        // Continuations may push, which can move reqs around
+        struct async_req req = queue->reqs[i];
+        xcb_generic_error_t* error = NULL;
+        void* reply;
+
+        reply = stats_reply(xcb_wait_for_reply(dpy, req.sequence, &error));
+        stats_reply(error);
+        req.cb(req.data, reply);
+        stats_reply_free(error);
+        stats_reply_free(reply);
+    }
+
+    queue->len -= n;
+    memmove(queue->reqs, queue->reqs + n, queue->len * sizeof(struct async_req));
+}
+
+void async_free(struct async_queue* queue, xcb_connection_t* dpy) {
+    for(size_t i = 0; i < queue->len; i++) {
+        xcb_discard_reply(dpy, queue->reqs[i].sequence);
+    }
+    free(queue->reqs);
+    queue->reqs = NULL;
+    queue->len = 0;
+    queue->cap = 0;
+}
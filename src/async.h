@@ -0,0 +1,59 @@
+#ifndef ASYNC_H
+#define ASYNC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <xcb/xcb.h>
+
+/*
+ * Pipelined replies.
+ *
+ * Instead of asking the server something and waiting for the answer
+ * right away, send the request, hand its sequence number to
+ * async_push() together with what to do with the reply, and carry on.
+ * async_resolve() collects every outstanding reply at once, so all
+ * queries made while handling a batch of events share one round trip.
+ */
+
+/*
+ * Continuation for a reply. reply is NULL if the request failed. It is
+ * freed after the callback returns, so don't keep it.
+ */
+typedef void (*async_cb)(void* data, void* reply);
+
+struct async_req {
+    unsigned int sequence;
+    async_cb cb;
+    void* data;
+};
+
+struct async_queue {
+    struct async_req* reqs;
+    size_t len;
+    size_t cap;
+};
+
+#define ASYNC_QUEUE_INIT { NULL, 0, 0 }
+
+/*
+ * Remember to call cb with the reply to request sequence.
+ *
+ * Returns false if out of memory. The reply is discarded then.
+ */
+bool async_push(struct async_queue* queue, xcb_connection_t* dpy,
+                unsigned int sequence, async_cb cb, void* data);
+
+/*
+ * Wait for all replies queued so far and run their continuations, in
+ * the order the requests were made. Requests pushed by a continuation
+ * are left for the next call.
+ */
+void async_resolve(struct async_queue* queue, xcb_connection_t* dpy);
+
+/*
+ * Forget everything queued, without waiting for the replies.
+ */
+void async_free(struct async_queue* queue, xcb_connection_t* dpy);
+
+#endif /* ASYNC_H */
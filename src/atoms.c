@@ -0,0 +1,39 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "atoms.h"
+#include "stats.h"
+
+xcb_atom_t atoms[ATOM_COUNT];
+
+static const char* atom_names[ATOM_COUNT] = {
+#define ATOM_NAME(name) #name,
+    ATOMS(ATOM_NAME)
+#undef ATOM_NAME
+};
+
+bool atoms_init(xcb_connection_t* dpy) {
+    xcb_intern_atom_cookie_t cookies[ATOM_COUNT];
+    bool ok = true;
+
+    for(int i = 0; i < ATOM_COUNT; i++) {
+        cookies[i] = xcb_intern_atom(dpy, 0, strlen(atom_names[i]), atom_names[i]);
+    }
+
+    // Waiting for the first one sends them all; the rest are already
+    // here by the time it arrives
+    stats.roundtrips++;
+    for(int i = 0; i < ATOM_COUNT; i++) {
+        xcb_intern_atom_reply_t* reply = stats_reply(xcb_intern_atom_reply(dpy, cookies[i], NULL));
+
+        if(reply == NULL) {
+            atoms[i] = XCB_NONE;
+            ok = false;
+            continue;
+        }
+        atoms[i] = reply->atom;
+        stats_reply_free(reply);
+    }
+
+    return ok;
+}
@@ -0,0 +1,58 @@
+#ifndef ATOMS_H
+#define ATOMS_H
+
+#include <stdbool.h>
+
+#include <xcb/xcb.h>
+
+/*
+ * Every atom qtwm uses, interned once at startup.
+ *
+ * All the InternAtom requests go out together and the replies are
+ * collected together, so the whole table costs one round trip. After
+ * that, atoms[ATOM_FOO] is a plain array load.
+ *
+ * To use a new atom, add it to ATOMS.
+ */
+
+#define ATOMS(X) \
+    X(UTF8_STRING) \
+    X(WM_PROTOCOLS) \
+    X(WM_DELETE_WINDOW) \
+    X(WM_TAKE_FOCUS) \
+    X(WM_STATE) \
+    X(_NET_SUPPORTED) \
+    X(_NET_SUPPORTING_WM_CHECK) \
+    X(_NET_WM_NAME) \
+    X(_NET_WM_STATE) \
+    X(_NET_WM_STATE_FULLSCREEN) \
+    X(_NET_WM_WINDOW_TYPE) \
+    X(_NET_WM_SYNC_REQUEST) \
+    X(_NET_WM_SYNC_REQUEST_COUNTER) \
+    X(_NET_ACTIVE_WINDOW) \
+    X(_NET_CLIENT_LIST) \
+    X(_NET_CLIENT_LIST_STACKING) \
+    X(_NET_NUMBER_OF_DESKTOPS) \
+    X(_NET_CURRENT_DESKTOP) \
+    X(_NET_CLOSE_WINDOW)
+
+enum atom_id {
+#define ATOM_ENUM(name) ATOM_##name,
+    ATOMS(ATOM_ENUM)
+#undef ATOM_ENUM
+    ATOM_COUNT
+};
+
+extern xcb_atom_t atoms[ATOM_COUNT];
+
+/* ICCCM values of WM_STATE */
+#define WM_STATE_WITHDRAWN 0
+#define WM_STATE_NORMAL 1
+#define WM_STATE_ICONIC 3
+
+/*
+ * Intern every atom in ATOMS. Returns false if any of them failed.
+ */
+bool atoms_init(xcb_connection_t* dpy);
+
+#endif /* ATOMS_H */
@@ -0,0 +1,114 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "clientlist.h"
+
+static int64_t clientlist_find(const struct clientlist* list, xcb_window_t window) {
+    // Recent windows are the likely ones to change, so look from the end
+    for(int64_t i = (int64_t) list->len - 1; i >= 0; i--) {
+        if(list->ids[i] == window) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+bool clientlist_append(struct clientlist* list, xcb_window_t window) {
+    if(list->len == list->cap) {
+        uint32_t cap = list->cap ? list->cap * 2 : 64;
+        xcb_window_t* ids = realloc(list->ids, cap * sizeof(xcb_window_t));
+
+        if(ids == NULL) {
+            return false;
+        }
+        list->ids = ids;
+        list->cap = cap;
+    }
+    list->ids[list->len++] = window;
+
+    return true;
+}
+
+/*
+ * Everything from i on is about to change.
+ */
+static void clientlist_changed_from(struct clientlist* list, uint32_t i) {
+    if(i < list->published) {
+        list->rewrite = true;
+    }
+}
+
+void clientlist_remove(struct clientlist* list, xcb_window_t window) {
+    int64_t i = clientlist_find(list, window);
+
+    if(i < 0) {
+        return;
+    }
+    clientlist_changed_from(list, (uint32_t) i);
+    memmove(&list->ids[i], &list->ids[i + 1], (list->len - i - 1) * sizeof(xcb_window_t));
+    list->len--;
+    if(list->published > list->len) {
+        list->published = list->len;
+    }
+}
+
+void clientlist_raise(struct clientlist* list, xcb_window_t window) {
+    int64_t i = clientlist_find(list, window);
+
+    if(i < 0 || (uint32_t) i == list->len - 1) {
+        return;
+    }
+    clientlist_changed_from(list, (uint32_t) i);
+    memmove(&list->ids[i], &list->ids[i + 1], (list->len - i - 1) * sizeof(xcb_window_t));
+    list->ids[list->len - 1] = window;
+}
+
+void clientlist_lower(struct clientlist* list, xcb_window_t window) {
+    int64_t i = clientlist_find(list, window);
+
+    if(i <= 0) {
+        return;
+    }
+    clientlist_changed_from(list, 0);
+    memmove(&list->ids[1], &list->ids[0], i * sizeof(xcb_window_t));
+    list->ids[0] = window;
+}
+
+void clientlist_place(struct clientlist* list, xcb_window_t window, xcb_window_t below) {
+    int64_t i = clientlist_find(list, window);
+    int64_t b = below == XCB_NONE ? -1 : clientlist_find(list, below);
+
+    if(i < 0 || (below != XCB_NONE && b < 0) || b + 1 == i) {
+        return;
+    }
+    clientlist_changed_from(list, (uint32_t) (i < b + 1 ? i : b + 1));
+    memmove(&list->ids[i], &list->ids[i + 1], (list->len - i - 1) * sizeof(xcb_window_t));
+    // Everything above i moved down one
+    if(b > i) {
+        b--;
+    }
+    memmove(&list->ids[b + 2], &list->ids[b + 1], (list->len - 1 - (b + 1)) * sizeof(xcb_window_t));
+    list->ids[b + 1] = window;
+}
+
+void clientlist_flush(struct clientlist* list, xcb_connection_t* dpy, xcb_window_t root) {
+    if(list->rewrite) {
+        xcb_change_property(dpy, XCB_PROP_MODE_REPLACE, root, list->atom, XCB_ATOM_WINDOW, 32,
+                            list->len, list->ids);
+    } else if(list->published < list->len) {
+        xcb_change_property(dpy, XCB_PROP_MODE_APPEND, root, list->atom, XCB_ATOM_WINDOW, 32,
+                            list->len - list->published, &list->ids[list->published]);
+    }
+    list->published = list->len;
+    list->rewrite = false;
+}
+
+void clientlist_free(struct clientlist* list) {
+    free(list->ids);
+    list->ids = NULL;
+    list->len = 0;
+    list->cap = 0;
+    list->published = 0;
+    list->rewrite = true;
+}
@@ -0,0 +1,68 @@
+#ifndef CLIENTLIST_H
+#define CLIENTLIST_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <xcb/xcb.h>
+
+/*
+ * A window list published as a root window property, like
+ * _NET_CLIENT_LIST.
+ *
+ * Changes only touch our copy. clientlist_flush() then brings the
+ * property up to date with as little as it can: windows added at the
+ * end go out in one PropMode Append, and only a removal or a reorder
+ * costs rewriting the whole list. Every panel watching the root gets
+ * one PropertyNotify per flush, however much changed.
+ */
+
+struct clientlist {
+    xcb_atom_t atom;
+    xcb_window_t* ids;
+    uint32_t len;
+    uint32_t cap;
+    /* ids[0..published) are on the server as they are here */
+    uint32_t published;
+    /* The server's copy is out of order; replace all of it */
+    bool rewrite;
+};
+
+/* Starts out wanting a rewrite, to clear what a previous WM left */
+#define CLIENTLIST_INIT { XCB_NONE, NULL, 0, 0, 0, true }
+
+/*
+ * Add window at the end. Returns false if out of memory.
+ */
+bool clientlist_append(struct clientlist* list, xcb_window_t window);
+
+/*
+ * Take window out of the list.
+ */
+void clientlist_remove(struct clientlist* list, xcb_window_t window);
+
+/*
+ * Move window to the end of the list (the top, for stacking order).
+ */
+void clientlist_raise(struct clientlist* list, xcb_window_t window);
+
+/*
+ * Move window to the start of the list (the bottom).
+ */
+void clientlist_lower(struct clientlist* list, xcb_window_t window);
+
+/*
+ * Move window to right above below, or to the start if below is
+ * XCB_NONE.
+ */
+void clientlist_place(struct clientlist* list, xcb_window_t window, xcb_window_t below);
+
+/*
+ * Send whatever changed since the last flush to root. Does not flush
+ * the connection.
+ */
+void clientlist_flush(struct clientlist* list, xcb_connection_t* dpy, xcb_window_t root);
+
+void clientlist_free(struct clientlist* list);
+
+#endif /* CLIENTLIST_H */
@@ -6,6 +6,7 @@
 /* Comment these out if you don't want them */
 #define DEBUG
 #define MULTIHEAD
+#define XSYNC
 
 /* Look in xproto.h for these values */
 #define MODIFIER_MASK XCB_MOD_MASK_1 | XCB_MOD_MASK_SHIFT
@@ -21,10 +22,38 @@
 #define BORDER_COLOR_UNFOCUSED 0xFF0000
 #define BORDER_COLOR_FOCUSED 0x0000FF
 
+/* During a resize, how long to wait before sending the next size to a
+ * client: if it doesn't do _NET_WM_SYNC_REQUEST, and if it does but
+ * doesn't answer. In milliseconds. */
+#define RESIZE_INTERVAL_MS 16
+#define SYNC_TIMEOUT_MS 100
+
 /* Border size in pixels */
 #define BORDER_WIDTH 2
 
-/* Kinda just a lot unused. Edge-padding in pixels */
+/* With DEBUG, check the geometry cache against the server this often,
+ * in milliseconds */
+#define GEOM_CHECK_INTERVAL_MS 10000
+
+/* Control socket; the first %s is the directory from ipc_dir(), the
+ * second the display, as in $DISPLAY */
+#define IPC_SOCKET "%s/qtwm%s.sock"
+
+/* Where to write the event loop statistics on SIGUSR1; the first %s is
+ * the directory from ipc_dir(), the second the display */
+#define STATS_FILE "%s/qtwm%s.stats"
+
+/* How to tile windows: LAYOUT_FLOATING (don't), LAYOUT_MASTER_STACK or
+ * LAYOUT_BSP */
+#define TILING_LAYOUT LAYOUT_FLOATING
+
+/* Number of workspaces */
+#define WORKSPACES 9
+
+/* Share of the width the master window gets, in percent */
+#define MASTER_PERCENT 55
+
+/* Edge-padding in pixels, kept free around tiled windows */
 #define LEFT_PADDING 4
 #define RIGHT_PADDING 4
 #define TOP_PADDING 24
@@ -0,0 +1,105 @@
+#include <stdlib.h>
+
+#include "configure.h"
+
+struct configure* configure_queue_add(struct configure_queue* queue,
+                                      const xcb_configure_request_event_t* e) {
+    struct configure* conf;
+    uintptr_t i = (uintptr_t) wintable_get(&queue->index, e->window);
+
+    if(i == 0) {
+        if(queue->len == queue->cap) {
+            uint32_t cap = queue->cap ? queue->cap * 2 : 16;
+            struct configure* reqs = realloc(queue->reqs, cap * sizeof(struct configure));
+
+            if(reqs == NULL) {
+                return NULL;
+            }
+            queue->reqs = reqs;
+            queue->cap = cap;
+        }
+        i = ++queue->len;
+        if(!wintable_put(&queue->index, e->window, (void*) i)) {
+            queue->len--;
+            return NULL;
+        }
+        conf = &queue->reqs[i - 1];
+        conf->window = e->window;
+        conf->mask = 0;
+    } else {
+        conf = &queue->reqs[i - 1];
+    }
+
+    if(e->value_mask & XCB_CONFIG_WINDOW_X) {
+        conf->x = e->x;
+    }
+    if(e->value_mask & XCB_CONFIG_WINDOW_Y) {
+        conf->y = e->y;
+    }
+    if(e->value_mask & XCB_CONFIG_WINDOW_WIDTH) {
+        conf->w = e->width;
+    }
+    if(e->value_mask & XCB_CONFIG_WINDOW_HEIGHT) {
+        conf->h = e->height;
+    }
+    if(e->value_mask & XCB_CONFIG_WINDOW_BORDER_WIDTH) {
+        conf->border = e->border_width;
+    }
+    if(e->value_mask & XCB_CONFIG_WINDOW_STACK_MODE) {
+        // A sibling only means something together with its stack mode,
+        // so a new stack mode drops any older sibling
+        conf->stack_mode = e->stack_mode;
+        conf->mask &= ~XCB_CONFIG_WINDOW_SIBLING;
+    }
+    if(e->value_mask & XCB_CONFIG_WINDOW_SIBLING) {
+        conf->sibling = e->sibling;
+    }
+    conf->mask |= e->value_mask;
+
+    return conf;
+}
+
+unsigned int configure_send(xcb_connection_t* dpy, const struct configure* conf) {
+    // Values go in the order of their mask bits
+    uint32_t values[7];
+    uint32_t n = 0;
+    uint16_t mask = conf->mask;
+
+    // A sibling without a stack mode is a BadMatch
+    if(!(mask & XCB_CONFIG_WINDOW_STACK_MODE)) {
+        mask &= ~XCB_CONFIG_WINDOW_SIBLING;
+    }
+
+    if(mask & XCB_CONFIG_WINDOW_X) {
+        values[n++] = (uint32_t) conf->x;
+    }
+    if(mask & XCB_CONFIG_WINDOW_Y) {
+        values[n++] = (uint32_t) conf->y;
+    }
+    if(mask & XCB_CONFIG_WINDOW_WIDTH) {
+        values[n++] = conf->w;
+    }
+    if(mask & XCB_CONFIG_WINDOW_HEIGHT) {
+        values[n++] = conf->h;
+    }
+    if(mask & XCB_CONFIG_WINDOW_BORDER_WIDTH) {
+        values[n++] = conf->border;
+    }
+    if(mask & XCB_CONFIG_WINDOW_SIBLING) {
+        values[n++] = conf->sibling;
+    }
+    if(mask & XCB_CONFIG_WINDOW_STACK_MODE) {
+        values[n++] = conf->stack_mode;
+    }
+
+    if(n == 0) {
+        return 0;
+    }
+
+    return xcb_configure_window(dpy, conf->window, mask, values).sequence;
+}
+
+void configure_queue_clear(struct configure_queue* queue) {
+    queue->len = 0;
+    wintable_clear(&queue->index);
+}
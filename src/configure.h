@@ -0,0 +1,62 @@
+#ifndef CONFIGURE_H
+#define CONFIGURE_H
+
+#include <stdint.h>
+
+#include <xcb/xcb.h>
+
+#include "wintable.h"
+
+/*
+ * ConfigureRequest coalescing.
+ *
+ * Clients that resize in a loop send request after request. We only
+ * collect them while handling a batch of events, merging everything
+ * asked of the same window, and then send one ConfigureWindow per
+ * window with the final result.
+ */
+
+struct configure {
+    xcb_window_t window;
+    /* XCB_CONFIG_WINDOW_* bits that have been asked for */
+    uint16_t mask;
+    int16_t x;
+    int16_t y;
+    uint16_t w;
+    uint16_t h;
+    uint16_t border;
+    xcb_window_t sibling;
+    uint8_t stack_mode;
+};
+
+struct configure_queue {
+    struct configure* reqs;
+    uint32_t len;
+    uint32_t cap;
+    /* Window -> index into reqs, plus one */
+    struct wintable index;
+};
+
+#define CONFIGURE_QUEUE_INIT { NULL, 0, 0, WINTABLE_INIT }
+
+/*
+ * Merge the request e into whatever is pending for its window. Later
+ * values win.
+ *
+ * Returns the pending configure, or NULL if out of memory.
+ */
+struct configure* configure_queue_add(struct configure_queue* queue,
+                                      const xcb_configure_request_event_t* e);
+
+/*
+ * Send one merged configure. Returns its sequence number, or 0 if
+ * there was nothing to send.
+ */
+unsigned int configure_send(xcb_connection_t* dpy, const struct configure* conf);
+
+/*
+ * Forget everything pending.
+ */
+void configure_queue_clear(struct configure_queue* queue);
+
+#endif /* CONFIGURE_H */
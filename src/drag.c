@@ -0,0 +1,75 @@
+#include "config.h"
+#include "drag.h"
+
+void drag_begin(struct drag* drag, enum drag_mode mode, xcb_window_t window,
+                int16_t anchor_x, int16_t anchor_y,
+                int16_t x, int16_t y, uint16_t w, uint16_t h) {
+    drag->mode = mode;
+    drag->window = window;
+    drag->anchor_x = anchor_x;
+    drag->anchor_y = anchor_y;
+    drag->x = x;
+    drag->y = y;
+    drag->w = w;
+    drag->h = h;
+    drag->pointer_x = anchor_x;
+    drag->pointer_y = anchor_y;
+    drag->pending = false;
+    drag->waiting = false;
+}
+
+void drag_motion(struct drag* drag, int16_t root_x, int16_t root_y) {
+    if(drag->mode == DRAG_NONE) {
+        return;
+    }
+    drag->pointer_x = root_x;
+    drag->pointer_y = root_y;
+    drag->pending = true;
+}
+
+bool drag_next(struct drag* drag, xcb_rectangle_t* geom) {
+    int32_t xdiff, ydiff;
+
+    if(drag->mode == DRAG_NONE || !drag->pending) {
+        return false;
+    }
+    // Keep the newest position until the client is ready for it
+    if(drag->mode == DRAG_RESIZE && drag->waiting) {
+        return false;
+    }
+    drag->pending = false;
+
+    xdiff = drag->pointer_x - drag->anchor_x;
+    ydiff = drag->pointer_y - drag->anchor_y;
+
+    if(drag->mode == DRAG_MOVE) {
+        geom->x = (int16_t) (drag->x + xdiff);
+        geom->y = (int16_t) (drag->y + ydiff);
+        geom->width = drag->w;
+        geom->height = drag->h;
+        return true;
+    }
+
+    // Resizing: don't go below the smallest allowed size
+    if(drag->w + xdiff < MIN_WINDOW_SIZE || drag->h + ydiff < MIN_WINDOW_SIZE) {
+        return false;
+    }
+    geom->x = drag->x;
+    geom->y = drag->y;
+    geom->width = (uint16_t) (drag->w + xdiff);
+    geom->height = (uint16_t) (drag->h + ydiff);
+    drag->waiting = true;
+
+    return true;
+}
+
+void drag_ready(struct drag* drag) {
+    drag->waiting = false;
+}
+
+void drag_end(struct drag* drag) {
+    drag->mode = DRAG_NONE;
+    drag->window = XCB_NONE;
+    drag->pending = false;
+    drag->waiting = false;
+}
@@ -0,0 +1,79 @@
+#ifndef DRAG_H
+#define DRAG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <xcb/xcb.h>
+
+/*
+ * Interactive move/resize.
+ *
+ * Everything the drag needs is captured when it starts, so following
+ * the pointer never has to ask the server anything. Motion events only
+ * record where the pointer is; drag_next() turns the newest position
+ * into at most one new geometry.
+ *
+ * Resizes are paced: once one has gone out, drag_next() holds the next
+ * back until drag_ready() says the client has caught up.
+ */
+
+enum drag_mode {
+    DRAG_NONE,
+    DRAG_MOVE,
+    DRAG_RESIZE
+};
+
+struct drag {
+    enum drag_mode mode;
+    xcb_window_t window;
+    /* Root coordinates of the pointer when the drag started */
+    int16_t anchor_x;
+    int16_t anchor_y;
+    /* Window geometry when the drag started */
+    int16_t x;
+    int16_t y;
+    uint16_t w;
+    uint16_t h;
+    /* Newest pointer position, root coordinates */
+    int16_t pointer_x;
+    int16_t pointer_y;
+    /* Pointer moved since the last drag_next() */
+    bool pending;
+    /* A resize went out that the client may not have handled yet */
+    bool waiting;
+};
+
+/*
+ * Start dragging window. anchor_x/anchor_y is where the pointer is now,
+ * x/y/w/h the current geometry of the window.
+ */
+void drag_begin(struct drag* drag, enum drag_mode mode, xcb_window_t window,
+                int16_t anchor_x, int16_t anchor_y,
+                int16_t x, int16_t y, uint16_t w, uint16_t h);
+
+/*
+ * Remember the newest pointer position. Sends nothing.
+ */
+void drag_motion(struct drag* drag, int16_t root_x, int16_t root_y);
+
+/*
+ * Geometry for the newest pointer position, if it moved and it's time
+ * to send it.
+ *
+ * Returns true and stores the geometry in geom if there's something to
+ * send. For resizes, the drag then waits for drag_ready().
+ */
+bool drag_next(struct drag* drag, xcb_rectangle_t* geom);
+
+/*
+ * The client has caught up with the last resize; the next may go out.
+ */
+void drag_ready(struct drag* drag);
+
+/*
+ * Stop dragging.
+ */
+void drag_end(struct drag* drag);
+
+#endif /* DRAG_H */
@@ -0,0 +1,197 @@
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "ipc.h"
+
+struct ipc_conn {
+    struct loop_source source;
+    struct ipc* ipc;
+    struct ipc_conn* next;
+};
+
+/* Requests are handled one at a time, so they can share a buffer */
+static struct ipc_command ipc_buf[IPC_MAX_COMMANDS];
+
+static void ipc_hangup(struct ipc_conn* conn) {
+    struct ipc_conn** p;
+
+    for(p = &conn->ipc->conns; *p != NULL; p = &(*p)->next) {
+        if(*p == conn) {
+            *p = conn->next;
+            break;
+        }
+    }
+    loop_del(conn->ipc->loop, &conn->source);
+    close(conn->source.fd);
+    free(conn);
+}
+
+static void ipc_conn_ready(struct loop_source* source, uint32_t events) {
+    struct ipc_conn* conn = source->data;
+    const void* reply;
+    size_t len;
+    ssize_t n;
+
+    for(;;) {
+        n = recv(source->fd, ipc_buf, sizeof(ipc_buf), MSG_TRUNC);
+        if(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        // Closed, broken, or not speaking our language
+        if(n <= 0 || (size_t) n > sizeof(ipc_buf) || n % sizeof(struct ipc_command) != 0) {
+            ipc_hangup(conn);
+            return;
+        }
+
+        reply = conn->ipc->handler(ipc_buf, (uint32_t) (n / sizeof(struct ipc_command)), &len);
+        if(send(source->fd, reply, len, MSG_NOSIGNAL | MSG_DONTWAIT) < 0) {
+            ipc_hangup(conn);
+            return;
+        }
+    }
+
+    if(events & (EPOLLHUP | EPOLLERR)) {
+        ipc_hangup(conn);
+    }
+}
+
+static void ipc_accept(struct loop_source* source, uint32_t events) {
+    struct ipc* ipc = source->data;
+    struct ipc_conn* conn;
+    int fd;
+
+    while((fd = accept4(source->fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+        conn = malloc(sizeof(struct ipc_conn));
+        if(conn == NULL) {
+            close(fd);
+            continue;
+        }
+        conn->source.fd = fd;
+        conn->source.cb = ipc_conn_ready;
+        conn->source.data = conn;
+        conn->ipc = ipc;
+        if(!loop_add(ipc->loop, &conn->source, EPOLLIN)) {
+            close(fd);
+            free(conn);
+            continue;
+        }
+        conn->next = ipc->conns;
+        ipc->conns = conn;
+    }
+}
+
+bool ipc_private_dir(const char* path) {
+    char dir[sizeof(((struct sockaddr_un*) NULL)->sun_path)];
+    char* slash;
+    struct stat st;
+
+    if(strlen(path) >= sizeof(dir)) {
+        errno = ENAMETOOLONG;
+        return false;
+    }
+    strcpy(dir, path);
+    if((slash = strrchr(dir, '/')) == NULL || slash == dir) {
+        errno = EINVAL;
+        return false;
+    }
+    *slash = '\0';
+    if(mkdir(dir, 0700) != 0 && errno != EEXIST) {
+        return false;
+    }
+    if(lstat(dir, &st) != 0) {
+        return false;
+    }
+    if(!S_ISDIR(st.st_mode) || st.st_uid != getuid() || (st.st_mode & 077) != 0) {
+        errno = EACCES;
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ * Remove the socket at addr if it's left over from a qtwm that didn't
+ * get to clean up. Fails if one is still listening there.
+ */
+static bool ipc_clear_stale(const struct sockaddr_un* addr) {
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    int err;
+
+    if(fd < 0) {
+        return false;
+    }
+    if(connect(fd, (const struct sockaddr*) addr, sizeof(*addr)) == 0) {
+        close(fd);
+        errno = EADDRINUSE;
+        return false;
+    }
+    err = errno;
+    close(fd);
+    // Nothing there at all
+    if(err == ENOENT) {
+        return true;
+    }
+    // A socket nobody listens on any more
+    if(err == ECONNREFUSED) {
+        return unlink(addr->sun_path) == 0 || errno == ENOENT;
+    }
+    errno = err;
+
+    return false;
+}
+
+bool ipc_listen(struct ipc* ipc, struct loop* loop, const char* path, ipc_handler handler) {
+    struct sockaddr_un addr;
+
+    if(strlen(path) >= sizeof(addr.sun_path)) {
+        errno = ENAMETOOLONG;
+        return false;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    if(!ipc_private_dir(path) || !ipc_clear_stale(&addr)) {
+        return false;
+    }
+
+    ipc->listener.fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if(ipc->listener.fd < 0) {
+        return false;
+    }
+    ipc->listener.cb = ipc_accept;
+    ipc->listener.data = ipc;
+    ipc->loop = loop;
+    ipc->handler = handler;
+    ipc->conns = NULL;
+
+    if(bind(ipc->listener.fd, (struct sockaddr*) &addr, sizeof(addr)) != 0
+            || listen(ipc->listener.fd, 8) != 0
+            || !loop_add(loop, &ipc->listener, EPOLLIN)) {
+        close(ipc->listener.fd);
+        ipc->listener.fd = -1;
+        return false;
+    }
+    strcpy(ipc->path, path);
+
+    return true;
+}
+
+void ipc_close(struct ipc* ipc) {
+    if(ipc->listener.fd < 0) {
+        return;
+    }
+    while(ipc->conns != NULL) {
+        ipc_hangup(ipc->conns);
+    }
+    loop_del(ipc->loop, &ipc->listener);
+    close(ipc->listener.fd);
+    ipc->listener.fd = -1;
+    unlink(ipc->path);
+}
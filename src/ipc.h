@@ -0,0 +1,134 @@
+#ifndef IPC_H
+#define IPC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "loop.h"
+
+/*
+ * Control socket.
+ *
+ * A SOCK_SEQPACKET Unix socket, so every message arrives whole. A
+ * request is an array of struct ipc_command, as many as fit in
+ * IPC_MAX_COMMANDS; all of them are carried out before anything is
+ * sent to the X server, and then everything goes out in one flush. The
+ * answer is one struct ipc_reply, followed by a struct ipc_client per
+ * managed window if the request had an IPC_LIST in it.
+ *
+ * Everything is host byte order; the socket never leaves the machine.
+ */
+
+#define IPC_MAX_COMMANDS 4096
+
+enum ipc_op {
+    /* List every managed window in the reply */
+    IPC_LIST = 1,
+    /* Move window to x/y */
+    IPC_MOVE,
+    /* Resize window to w/h */
+    IPC_RESIZE,
+    /* Both */
+    IPC_MOVE_RESIZE,
+    /* Raise window and give it the input focus */
+    IPC_FOCUS,
+    /* Ask window to close */
+    IPC_CLOSE,
+    /* Show workspace x; window is ignored */
+    IPC_WORKSPACE,
+    /* Move window to workspace x */
+    IPC_SEND_TO_WORKSPACE
+};
+
+struct ipc_command {
+    uint8_t op;
+    uint8_t pad[3];
+    uint32_t window;
+    int16_t x;
+    int16_t y;
+    uint16_t w;
+    uint16_t h;
+};
+
+struct ipc_reply {
+    /* Commands carried out */
+    uint32_t done;
+    /* Commands for windows we don't manage, or with an unknown op */
+    uint32_t failed;
+    /* Number of struct ipc_client that follow */
+    uint32_t clients;
+    uint32_t pad;
+};
+
+struct ipc_client {
+    uint32_t window;
+    int16_t x;
+    int16_t y;
+    uint16_t w;
+    uint16_t h;
+    uint16_t border;
+    uint16_t pad;
+};
+
+/*
+ * Carry out the n commands in cmds. Returns the answer, len bytes of
+ * it, which has to stay around until the next call.
+ */
+typedef const void* (*ipc_handler)(const struct ipc_command* cmds, uint32_t n, size_t* len);
+
+struct ipc_conn;
+
+struct ipc {
+    /* The listening socket */
+    struct loop_source listener;
+    struct loop* loop;
+    ipc_handler handler;
+    /* Connected clients */
+    struct ipc_conn* conns;
+    char path[108];
+};
+
+#define IPC_INIT { { -1, NULL, NULL }, NULL, NULL, NULL, "" }
+
+/*
+ * Directory for the control socket, written to buf: $XDG_RUNTIME_DIR,
+ * or else /tmp/qtwm-<uid>, which ipc_listen() makes private. Returns
+ * buf.
+ */
+static inline const char* ipc_dir(char* buf, size_t len) {
+    const char* runtime = getenv("XDG_RUNTIME_DIR");
+
+    if(runtime != NULL && runtime[0] == '/') {
+        snprintf(buf, len, "%s", runtime);
+    } else {
+        snprintf(buf, len, "/tmp/qtwm-%u", (unsigned int) getuid());
+    }
+
+    return buf;
+}
+
+/*
+ * Make sure the directory path is in exists, is ours and nobody else
+ * can get in, so nobody else can put a file where we'd look. Returns
+ * false otherwise, with errno set.
+ */
+bool ipc_private_dir(const char* path);
+
+/*
+ * Listen on path and handle requests from loop. The directory path is
+ * in must be ours and closed to everyone else; it's made if it isn't
+ * there. A socket already at path is only replaced if nobody answers
+ * on it. Returns false on error, with errno set.
+ */
+bool ipc_listen(struct ipc* ipc, struct loop* loop, const char* path, ipc_handler handler);
+
+/*
+ * Hang up on everyone and remove the socket.
+ */
+void ipc_close(struct ipc* ipc);
+
+#endif /* IPC_H */
@@ -0,0 +1,348 @@
+#include <string.h>
+
+#include "config.h"
+#include "layout.h"
+#include "pool.h"
+
+/* Where the nodes of every layout come from */
+static struct pool layout_pool = POOL_INIT(struct layout_node, 64);
+
+static struct layout_node* layout_node_new(xcb_window_t window) {
+    struct layout_node* node = pool_alloc(&layout_pool);
+
+    if(node == NULL) {
+        return NULL;
+    }
+    memset(node, 0, sizeof(struct layout_node));
+    node->window = window;
+    node->weight = 1;
+
+    return node;
+}
+
+/*
+ * Mark node and everything above it as changed. Whatever is already
+ * dirty has dirty parents, so we can stop there.
+ */
+static void layout_mark(struct layout_node* node) {
+    while(node != NULL && !node->dirty) {
+        node->dirty = true;
+        node = node->parent;
+    }
+}
+
+static void layout_append(struct layout_node* parent, struct layout_node* child) {
+    struct layout_node** p = &parent->children;
+
+    while(*p != NULL) {
+        p = &(*p)->next;
+    }
+    *p = child;
+    child->next = NULL;
+    child->parent = parent;
+}
+
+static void layout_prepend(struct layout_node* parent, struct layout_node* child) {
+    child->next = parent->children;
+    child->parent = parent;
+    parent->children = child;
+}
+
+static void layout_unlink(struct layout_node* child) {
+    struct layout_node** p = &child->parent->children;
+
+    while(*p != child) {
+        p = &(*p)->next;
+    }
+    *p = child->next;
+    child->next = NULL;
+}
+
+/*
+ * Put node where old is in the tree. old is left unlinked.
+ */
+static void layout_replace(struct layout* layout, struct layout_node* old, struct layout_node* node) {
+    struct layout_node** p;
+
+    node->parent = old->parent;
+    node->weight = old->weight;
+    if(old->parent == NULL) {
+        layout->root = node;
+        node->next = NULL;
+        return;
+    }
+    p = &old->parent->children;
+    while(*p != old) {
+        p = &(*p)->next;
+    }
+    *p = node;
+    node->next = old->next;
+    old->next = NULL;
+}
+
+static struct layout_node* layout_last_leaf(struct layout_node* node) {
+    while(node->window == XCB_NONE) {
+        node = node->children;
+        while(node->next != NULL) {
+            node = node->next;
+        }
+    }
+
+    return node;
+}
+
+void layout_init(struct layout* layout, enum layout_mode mode, xcb_rectangle_t area) {
+    layout->mode = mode;
+    layout->root = NULL;
+    layout->focus = NULL;
+    layout->leaves = (struct wintable) WINTABLE_INIT;
+    layout->area = area;
+}
+
+/*
+ * The master is the root's first child, and the stack its second.
+ */
+static bool layout_insert_master_stack(struct layout* layout, struct layout_node* leaf) {
+    struct layout_node* root = layout->root;
+    struct layout_node* stack;
+
+    if(root == NULL) {
+        if((root = layout_node_new(XCB_NONE)) == NULL) {
+            return false;
+        }
+        layout->root = root;
+        leaf->weight = MASTER_PERCENT;
+        layout_append(root, leaf);
+        layout_mark(root);
+        return true;
+    }
+
+    stack = root->children->next;
+    if(stack == NULL) {
+        if((stack = layout_node_new(XCB_NONE)) == NULL) {
+            return false;
+        }
+        stack->vertical = true;
+        stack->weight = 100 - MASTER_PERCENT;
+        layout_append(root, stack);
+    }
+    // The master stays put; only the stack makes room
+    layout_append(stack, leaf);
+    layout_mark(stack);
+
+    return true;
+}
+
+static bool layout_insert_bsp(struct layout* layout, struct layout_node* leaf) {
+    struct layout_node* target;
+    struct layout_node* split;
+
+    if(layout->root == NULL) {
+        layout->root = leaf;
+        layout_mark(leaf);
+        return true;
+    }
+
+    target = layout->focus ? layout->focus : layout_last_leaf(layout->root);
+    if((split = layout_node_new(XCB_NONE)) == NULL) {
+        return false;
+    }
+    // Split along the long side
+    split->vertical = target->rect.height > target->rect.width;
+    split->rect = target->rect;
+    layout_replace(layout, target, split);
+    target->weight = 1;
+    layout_append(split, target);
+    layout_append(split, leaf);
+    layout_mark(split);
+
+    return true;
+}
+
+bool layout_insert(struct layout* layout, xcb_window_t window) {
+    struct layout_node* leaf;
+    bool ok;
+
+    if(layout->mode == LAYOUT_FLOATING || wintable_get(&layout->leaves, window) != NULL) {
+        return false;
+    }
+    if((leaf = layout_node_new(window)) == NULL) {
+        return false;
+    }
+    if(!wintable_put(&layout->leaves, window, leaf)) {
+        pool_free(&layout_pool, leaf);
+        return false;
+    }
+
+    ok = layout->mode == LAYOUT_MASTER_STACK ? layout_insert_master_stack(layout, leaf)
+         : layout_insert_bsp(layout, leaf);
+    if(!ok) {
+        wintable_del(&layout->leaves, window);
+        pool_free(&layout_pool, leaf);
+        return false;
+    }
+    layout->focus = leaf;
+
+    return true;
+}
+
+static void layout_remove_master_stack(struct layout* layout, struct layout_node* leaf) {
+    struct layout_node* root = layout->root;
+    struct layout_node* parent = leaf->parent;
+    struct layout_node* stack;
+    struct layout_node* master;
+
+    layout_unlink(leaf);
+
+    if(parent != root) {
+        // Out of the stack
+        if(parent->children == NULL) {
+            layout_unlink(parent);
+            pool_free(&layout_pool, parent);
+            layout_mark(root);
+        } else {
+            layout_mark(parent);
+        }
+        return;
+    }
+
+    // The master is gone; the top of the stack takes over
+    stack = root->children;
+    if(stack == NULL) {
+        pool_free(&layout_pool, root);
+        layout->root = NULL;
+        return;
+    }
+    master = stack->children;
+    layout_unlink(master);
+    master->weight = MASTER_PERCENT;
+    layout_prepend(root, master);
+    if(stack->children == NULL) {
+        layout_unlink(stack);
+        pool_free(&layout_pool, stack);
+    } else {
+        layout_mark(stack);
+    }
+    layout_mark(root);
+}
+
+static void layout_remove_bsp(struct layout* layout, struct layout_node* leaf) {
+    struct layout_node* parent = leaf->parent;
+    struct layout_node* sibling;
+
+    if(parent == NULL) {
+        layout->root = NULL;
+        return;
+    }
+
+    // The sibling gets the whole of what the two of them had
+    layout_unlink(leaf);
+    sibling = parent->children;
+    layout_replace(layout, parent, sibling);
+    pool_free(&layout_pool, parent);
+    layout_mark(sibling->parent ? sibling->parent : sibling);
+}
+
+bool layout_remove(struct layout* layout, xcb_window_t window) {
+    struct layout_node* leaf = wintable_del(&layout->leaves, window);
+
+    if(leaf == NULL) {
+        return false;
+    }
+    if(layout->mode == LAYOUT_MASTER_STACK) {
+        layout_remove_master_stack(layout, leaf);
+    } else {
+        layout_remove_bsp(layout, leaf);
+    }
+    if(layout->focus == leaf) {
+        layout->focus = NULL;
+    }
+    pool_free(&layout_pool, leaf);
+
+    return true;
+}
+
+void layout_focus(struct layout* layout, xcb_window_t window) {
+    struct layout_node* leaf = wintable_get(&layout->leaves, window);
+
+    if(leaf != NULL) {
+        layout->focus = leaf;
+    }
+}
+
+void layout_set_area(struct layout* layout, xcb_rectangle_t area) {
+    // The root's rectangle no longer matches, which is all it takes
+    layout->area = area;
+}
+
+static inline bool layout_rect_eq(xcb_rectangle_t a, xcb_rectangle_t b) {
+    return a.x == b.x && a.y == b.y && a.width == b.width && a.height == b.height;
+}
+
+static void layout_apply_node(struct layout_node* node, xcb_rectangle_t rect, layout_place_cb place) {
+    struct layout_node* child;
+    uint32_t total = 0;
+    uint32_t acc = 0;
+    uint32_t used = 0;
+    uint32_t length;
+
+    // Nothing changed in here, and it's still in the same spot
+    if(!node->dirty && layout_rect_eq(node->rect, rect)) {
+        return;
+    }
+    node->dirty = false;
+    node->rect = rect;
+
+    if(node->window != XCB_NONE) {
+        place(node->window, rect);
+        return;
+    }
+
+    for(child = node->children; child != NULL; child = child->next) {
+        total += child->weight;
+    }
+    length = node->vertical ? rect.height : rect.width;
+
+    // Cut by running total, so the pieces always add up exactly
+    for(child = node->children; child != NULL; child = child->next) {
+        xcb_rectangle_t piece = rect;
+        uint32_t end;
+
+        acc += child->weight;
+        end = (uint32_t) ((uint64_t) length * acc / total);
+        if(node->vertical) {
+            piece.y = (int16_t) (rect.y + used);
+            piece.height = (uint16_t) (end - used);
+        } else {
+            piece.x = (int16_t) (rect.x + used);
+            piece.width = (uint16_t) (end - used);
+        }
+        used = end;
+        layout_apply_node(child, piece, place);
+    }
+}
+
+void layout_apply(struct layout* layout, layout_place_cb place) {
+    if(layout->root != NULL) {
+        layout_apply_node(layout->root, layout->area, place);
+    }
+}
+
+static void layout_free_node(struct layout_node* node) {
+    while(node->children != NULL) {
+        struct layout_node* child = node->children;
+
+        node->children = child->next;
+        layout_free_node(child);
+    }
+    pool_free(&layout_pool, node);
+}
+
+void layout_free(struct layout* layout) {
+    if(layout->root != NULL) {
+        layout_free_node(layout->root);
+    }
+    layout->root = NULL;
+    layout->focus = NULL;
+    wintable_free(&layout->leaves);
+}
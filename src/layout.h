@@ -0,0 +1,100 @@
+#ifndef LAYOUT_H
+#define LAYOUT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <xcb/xcb.h>
+
+#include "wintable.h"
+
+/*
+ * Tiling layouts.
+ *
+ * A layout is a tree over one area of the screen. Leaves are windows,
+ * inner nodes split their rectangle between their children, side by
+ * side or top to bottom, in proportion to the children's weights.
+ *
+ * Changing the tree marks the nodes it touched, and everything above
+ * them, as dirty. layout_apply() only walks down into dirty subtrees
+ * and subtrees whose rectangle changed, and only hands a window to the
+ * place callback if its rectangle actually moved. Opening a window
+ * next to forty others costs a configure for it and its neighbours,
+ * not for all forty.
+ */
+
+enum layout_mode {
+    /* Not tiled; windows stay where they're put */
+    LAYOUT_FLOATING,
+    /* One master window on the left, the rest stacked on the right */
+    LAYOUT_MASTER_STACK,
+    /* Every new window splits the focused one in two */
+    LAYOUT_BSP
+};
+
+struct layout_node {
+    struct layout_node* parent;
+    /* First child, and the next sibling */
+    struct layout_node* children;
+    struct layout_node* next;
+    /* Window of a leaf; XCB_NONE for inner nodes */
+    xcb_window_t window;
+    /* Children go top to bottom rather than left to right */
+    bool vertical;
+    /* Something in this subtree changed since the last apply */
+    bool dirty;
+    /* Share of the parent, relative to the siblings' weights */
+    uint16_t weight;
+    /* Rectangle as of the last apply, borders included */
+    xcb_rectangle_t rect;
+};
+
+struct layout {
+    enum layout_mode mode;
+    struct layout_node* root;
+    /* Where the next BSP split happens */
+    struct layout_node* focus;
+    /* Window -> leaf */
+    struct wintable leaves;
+    xcb_rectangle_t area;
+};
+
+/*
+ * Put a window at rect, borders included.
+ */
+typedef void (*layout_place_cb)(xcb_window_t window, xcb_rectangle_t rect);
+
+void layout_init(struct layout* layout, enum layout_mode mode, xcb_rectangle_t area);
+
+/*
+ * Tile window. Returns false if the layout doesn't tile or out of
+ * memory.
+ */
+bool layout_insert(struct layout* layout, xcb_window_t window);
+
+/*
+ * Stop tiling window. Returns false if it wasn't.
+ */
+bool layout_remove(struct layout* layout, xcb_window_t window);
+
+/*
+ * Make window's leaf the one the next BSP split happens at.
+ */
+void layout_focus(struct layout* layout, xcb_window_t window);
+
+/*
+ * Tile into area from now on.
+ */
+void layout_set_area(struct layout* layout, xcb_rectangle_t area);
+
+/*
+ * Place every window whose rectangle changed since the last apply.
+ */
+void layout_apply(struct layout* layout, layout_place_cb place);
+
+/*
+ * Forget every window and free the tree.
+ */
+void layout_free(struct layout* layout);
+
+#endif /* LAYOUT_H */
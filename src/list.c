@@ -73,7 +73,17 @@ struct item *additem(struct item **mainlist)
     {
         return NULL;
     }
-  
+
+    linkitem(mainlist, item);
+
+    return item;
+}
+
+/*
+ * Add item, allocated by the caller, to the head of mainlist.
+ */
+void linkitem(struct item **mainlist, struct item *item)
+{
     if (NULL == *mainlist)
     {
         /* First in the list. */
@@ -91,23 +101,31 @@ struct item *additem(struct item **mainlist)
     }
 
     *mainlist = item;
-        
-    return item;
 }
 
-void delitem(struct item **mainlist, struct item *item)
+/*
+ * Take item out of list mainlist without freeing it.
+ */
+void unlinkitem(struct item **mainlist, struct item *item)
 {
-    struct item *ml = *mainlist;
+    struct item *ml;
     
     if (NULL == mainlist || NULL == *mainlist || NULL == item)
     {
         return;
     }
 
+    ml = *mainlist;
+
     if (item == *mainlist)
     {
         /* First entry was removed. Remember the next one instead. */
         *mainlist = ml->next;
+
+        if (NULL != *mainlist)
+        {
+            (*mainlist)->prev = NULL;
+        }
     }
     else
     {
@@ -120,6 +138,18 @@ void delitem(struct item **mainlist, struct item *item)
         }
     }
 
+    item->prev = NULL;
+    item->next = NULL;
+}
+
+void delitem(struct item **mainlist, struct item *item)
+{
+    if (NULL == mainlist || NULL == *mainlist || NULL == item)
+    {
+        return;
+    }
+
+    unlinkitem(mainlist, item);
     free(item);
 }
 
@@ -25,6 +25,16 @@ void movetohead(struct item **mainlist, struct item *item);
  */
 struct item *additem(struct item **mainlist);
 
+/*
+ * Add item, allocated by the caller, to the head of mainlist.
+ */
+void linkitem(struct item **mainlist, struct item *item);
+
+/*
+ * Take item out of list mainlist without freeing it.
+ */
+void unlinkitem(struct item **mainlist, struct item *item);
+
 /*
  * Delete item from list mainlist.
  */ 
@@ -0,0 +1,117 @@
+#include <errno.h>
+#include <unistd.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+
+#include "loop.h"
+
+/* Ready sources handled per epoll_wait() */
+#define LOOP_MAX_EVENTS 16
+
+bool loop_init(struct loop* loop) {
+    loop->epfd = epoll_create1(EPOLL_CLOEXEC);
+    loop->running = loop->epfd >= 0;
+
+    return loop->running;
+}
+
+bool loop_add(struct loop* loop, struct loop_source* source, uint32_t events) {
+    struct epoll_event ev;
+
+    ev.events = events;
+    ev.data.ptr = source;
+
+    return epoll_ctl(loop->epfd, EPOLL_CTL_ADD, source->fd, &ev) == 0;
+}
+
+void loop_del(struct loop* loop, struct loop_source* source) {
+    epoll_ctl(loop->epfd, EPOLL_CTL_DEL, source->fd, NULL);
+}
+
+int loop_wait(struct loop* loop, int timeout_ms) {
+    struct epoll_event evs[LOOP_MAX_EVENTS];
+    int n;
+
+    n = epoll_wait(loop->epfd, evs, LOOP_MAX_EVENTS, timeout_ms);
+    if(n < 0) {
+        // A signal we don't take through a signalfd isn't an error
+        return errno == EINTR ? 0 : -1;
+    }
+
+    for(int i = 0; i < n; i++) {
+        struct loop_source* source = evs[i].data.ptr;
+
+        source->cb(source, evs[i].events);
+    }
+
+    return n;
+}
+
+void loop_stop(struct loop* loop) {
+    loop->running = false;
+}
+
+void loop_free(struct loop* loop) {
+    if(loop->epfd >= 0) {
+        close(loop->epfd);
+    }
+    loop->epfd = -1;
+    loop->running = false;
+}
+
+bool loop_timer_init(struct loop_source* source, loop_cb cb, void* data) {
+    source->fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    source->cb = cb;
+    source->data = data;
+
+    return source->fd >= 0;
+}
+
+void loop_timer_arm(struct loop_source* source, uint64_t ns, uint64_t interval_ns) {
+    struct itimerspec spec;
+
+    spec.it_value.tv_sec = ns / 1000000000u;
+    spec.it_value.tv_nsec = ns % 1000000000u;
+    spec.it_interval.tv_sec = interval_ns / 1000000000u;
+    spec.it_interval.tv_nsec = interval_ns % 1000000000u;
+    timerfd_settime(source->fd, 0, &spec, NULL);
+}
+
+uint64_t loop_timer_read(struct loop_source* source) {
+    uint64_t expirations;
+
+    if(read(source->fd, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+        return 0;
+    }
+
+    return expirations;
+}
+
+bool loop_signal_init(struct loop_source* source, const sigset_t* mask, loop_cb cb, void* data) {
+    // Blocked signals stay pending, which is what makes them readable
+    if(sigprocmask(SIG_BLOCK, mask, NULL) != 0) {
+        return false;
+    }
+    source->fd = signalfd(-1, mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    source->cb = cb;
+    source->data = data;
+
+    return source->fd >= 0;
+}
+
+int loop_signal_read(struct loop_source* source) {
+    struct signalfd_siginfo info;
+
+    if(read(source->fd, &info, sizeof(info)) != sizeof(info)) {
+        return 0;
+    }
+
+    return (int) info.ssi_signo;
+}
+
+void loop_source_close(struct loop_source* source) {
+    if(source->fd >= 0) {
+        close(source->fd);
+    }
+    source->fd = -1;
+}
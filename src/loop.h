@@ -0,0 +1,108 @@
+#ifndef LOOP_H
+#define LOOP_H
+
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/epoll.h>
+
+/*
+ * Main loop, built on epoll.
+ *
+ * Everything the window manager waits for is a file descriptor: the X
+ * connection, timers, signals and sockets. The loop sleeps until one
+ * of them is ready and runs its callback, so nothing ever polls and an
+ * idle window manager uses no CPU at all.
+ */
+
+struct loop_source;
+
+/*
+ * Called when source is ready. events are the EPOLL* bits that fired.
+ */
+typedef void (*loop_cb)(struct loop_source* source, uint32_t events);
+
+struct loop_source {
+    int fd;
+    loop_cb cb;
+    void* data;
+};
+
+struct loop {
+    int epfd;
+    /* Cleared by loop_stop() */
+    bool running;
+};
+
+#define LOOP_INIT { -1, false }
+
+/*
+ * Set up the loop. Returns false on error.
+ */
+bool loop_init(struct loop* loop);
+
+/*
+ * Call source->cb whenever source->fd is ready for events (EPOLLIN
+ * and friends). source must stay where it is until it's removed.
+ *
+ * Returns false on error.
+ */
+bool loop_add(struct loop* loop, struct loop_source* source, uint32_t events);
+
+/*
+ * Stop watching source. Does not close its fd.
+ */
+void loop_del(struct loop* loop, struct loop_source* source);
+
+/*
+ * Wait up to timeout_ms (-1 for ever) for sources to be ready, and run
+ * their callbacks.
+ *
+ * Returns the number of callbacks run, or -1 on error.
+ */
+int loop_wait(struct loop* loop, int timeout_ms);
+
+/*
+ * Make loop_wait() callers stop at the next chance.
+ */
+void loop_stop(struct loop* loop);
+
+/*
+ * Close the loop. Sources are left alone.
+ */
+void loop_free(struct loop* loop);
+
+/*
+ * Make source a timer, disarmed. Returns false on error.
+ */
+bool loop_timer_init(struct loop_source* source, loop_cb cb, void* data);
+
+/*
+ * Fire after ns nanoseconds, then every interval_ns if that isn't 0.
+ * ns == 0 disarms the timer.
+ */
+void loop_timer_arm(struct loop_source* source, uint64_t ns, uint64_t interval_ns);
+
+/*
+ * From a timer's callback: how many times it fired since the last call.
+ */
+uint64_t loop_timer_read(struct loop_source* source);
+
+/*
+ * Make source deliver the signals in mask instead of their handlers
+ * (or default actions) running. Blocks them. Returns false on error.
+ */
+bool loop_signal_init(struct loop_source* source, const sigset_t* mask, loop_cb cb, void* data);
+
+/*
+ * From a signal source's callback: the next pending signal, or 0 if
+ * there are none left.
+ */
+int loop_signal_read(struct loop_source* source);
+
+/*
+ * Close the fd of a timer or signal source.
+ */
+void loop_source_close(struct loop_source* source);
+
+#endif /* LOOP_H */
@@ -2,17 +2,37 @@
  * Compliant to X11/ICCCM/EWMH specs? Who does that?
  */
 
+#include <fcntl.h>
+#include <signal.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #include <xcb/xcb.h>
 #include <xcb/xcb_atom.h>
-#include <xcb/xinerama.h>
 
+#include "async.h"
+#include "atoms.h"
+#include "clientlist.h"
 #include "config.h"
+#include "configure.h"
+#include "drag.h"
+#include "ipc.h"
+#include "layout.h"
 #include "list.h"
+#include "loop.h"
+#include "monitor.h"
+#include "pool.h"
+#include "props.h"
+#include "snapshot.h"
+#include "stack.h"
+#include "stats.h"
+#include "store.h"
+#include "trace.h"
+#include "wintable.h"
+#include "xsync.h"
 
 #ifdef DEBUG
 #define PDEBUG(...) \
@@ -43,19 +63,40 @@
  * Structs
  */
 
+/* Our own unmaps of one window we keep track of at once */
+#define CLIENT_UNMAPS 4
+
 struct client_win {
     /* Window ID */
     xcb_drawable_t id;
-    /* x/y coords */
-    int16_t x;
-    int16_t y;
-    /* Width and height */
-    uint16_t w;
-    uint16_t h;
-    /* Window item */
-    struct item* window_item;
+    /* Geometry and flags, in the client store */
+    store_handle_t handle;
+    /* Window item, linked into winlist */
+    struct item window_item;
+    /* Layout tiling this window, or NULL if it floats */
+    struct layout* layout;
+    /* Workspace the window is on */
+    uint32_t workspace;
+    /* Sequence numbers of our unmaps that may still have an
+     * UnmapNotify to come, oldest first */
+    unsigned int unmaps[CLIENT_UNMAPS];
+    uint8_t unmaps_len;
+    /* _NET_WM_SYNC_REQUEST_COUNTER, or XCB_NONE */
+    uint32_t sync_counter;
+    /* Last value we asked the counter to reach */
+    uint64_t sync_value;
 };
 
+/* Client flags, in the store */
+/* Takes WM_DELETE_WINDOW, so it can be asked to close */
+#define CLIENT_DELETE_WINDOW (1 << 0)
+/* Takes _NET_WM_SYNC_REQUEST, so resizes can wait for it */
+#define CLIENT_SYNC_REQUEST (1 << 1)
+/* Asked to be mapped, so it's in the client lists */
+#define CLIENT_LISTED (1 << 2)
+/* Mapped, by us or as far as the last MapNotify said */
+#define CLIENT_VIEWABLE (1 << 3)
+
 /*
  * Globals
  */
@@ -66,23 +107,203 @@ xcb_connection_t* dpy;
 /* Screen */
 xcb_screen_t* screen;
 
-/* List of current windows */
+/* List of current windows, most recently used first */
 struct item* winlist = NULL;
 
+/* Index of current windows by ID */
+struct wintable clients = WINTABLE_INIT;
+
+/* Where client_win structs come from */
+struct pool client_pool = POOL_INIT(struct client_win, 64);
+
+/* Titles, hints and such of current windows, as far as we needed them */
+struct propcache properties = PROPCACHE_INIT;
+
+/* Geometry of current windows, in dense arrays */
+struct store store = STORE_INIT;
+
+/* Interactive move/resize in progress, if any */
+struct drag drag = { .mode = DRAG_NONE };
+
+/* Button press on an unmanaged window, waiting for its geometry before
+ * a drag can start */
+struct {
+    xcb_window_t window;
+    enum drag_mode mode;
+} press = { XCB_NONE, DRAG_NONE };
+
+/* Sync alarm of the window being resized */
+struct xsync xsync = XSYNC_INIT;
+
+/* When the next size of a resize may go out, if the client can't tell
+ * us itself */
+struct loop_source resize_timer = { -1, NULL, NULL };
+
+/* ConfigureRequests of this batch, merged per window */
+struct configure_queue configures = CONFIGURE_QUEUE_INIT;
+
+/* Replies we're waiting for */
+struct async_queue replies = ASYNC_QUEUE_INIT;
+
+/* What the main loop waits on */
+struct loop loop = LOOP_INIT;
+struct loop_source x_source;
+struct loop_source signal_source;
+#ifdef DEBUG
+struct loop_source check_timer;
+#endif
+
+/* Stacking order of everything on the root, bottom to top */
+struct stack stack = STACK_INIT;
+
+/* Windows that asked to be mapped this batch, in that order. They're
+ * mapped once the batch's layouts and configures are out, so they show
+ * up where they belong. */
+struct stack pending_maps = STACK_INIT;
+
+/* Windows to tile once we know whether they're transient for another,
+ * in the order they asked to be mapped */
+struct stack pending_tiles = STACK_INIT;
+
+/* Managed windows for panels: oldest first, and bottom to top */
+struct clientlist client_list = CLIENTLIST_INIT;
+struct clientlist stacking_list = CLIENTLIST_INIT;
+
+/* Control socket */
+struct ipc ipc = IPC_INIT;
+
+/* Answer to the last control request */
+uint8_t* ipc_reply = NULL;
+size_t ipc_reply_cap = 0;
+
+/* Outputs, for "which monitor is this on?" */
+struct monitors monitors = MONITORS_INIT;
+
+/* Tiling layout of each monitor on each workspace: workspace w,
+ * monitor m is at w * layout_monitors + m */
+struct layout* layouts = NULL;
+uint32_t layout_monitors = 0;
+
+/* Workspace on screen */
+uint32_t workspace = 0;
+
+/* What the qtwm we were exec'd by knew, if we're a restart */
+struct snapshot snapshot = SNAPSHOT_INIT;
+
+/* Exec ourselves once the loop is done with what woke it */
+bool restarting = false;
+
+/* Our requests that may have moved windows under the pointer, by
+ * sequence number: the crossing events they cause are in [from, to].
+ * from is 0 while there are none outstanding. */
+struct {
+    uint32_t from;
+    uint32_t to;
+    /* A request has gone out after to, so the user's own crossings
+     * will carry a later sequence number */
+    bool fenced;
+} ours = { 0, 0, false };
+
+/* Window with the pointer in it, as of the crossing events so far, and
+ * the one whose border says so */
+xcb_window_t hover = XCB_NONE;
+xcb_window_t hover_shown = XCB_NONE;
+
+/* Where the pointer was last seen, root coordinates */
+int16_t pointer_x = 0;
+int16_t pointer_y = 0;
+
+/* We moved windows under the pointer, so hover may be wrong */
+bool hover_stale = false;
+
+/* Trace of every handled event, if we're recording one */
+struct trace recording = { NULL, 0, 0, 0, false };
+
+/* Replaying a trace, and whether the event being handled was caused by
+ * our own requests when it was recorded */
+bool replaying = false;
+bool replayed_ours = false;
+
 /*
  * Forward declarations
  */
 
-void new_window(xcb_window_t window);
+struct client_win* new_window(xcb_window_t window);
+void map_pending(void);
 void set_border_color(xcb_window_t window, bool focus);
 void set_border_width(xcb_window_t window);
-struct client_win* setup_window(xcb_window_t window);
+void adopt_windows(bool hidden_too);
+void unhide_snapshot(int fd);
+void restore_window(struct client_win* client, const struct snapshot_client* rec);
+void restore_order(void);
+void restart(char** argv);
+struct client_win* setup_window(xcb_window_t window, const xcb_get_geometry_reply_t* geom);
 void forgetwindow(xcb_window_t window);
-bool get_geom(xcb_drawable_t window, int16_t* x, int16_t* y, uint16_t* w, uint16_t* h);
+void setup_window_geom(void* data, void* reply);
+void get_protocols(xcb_window_t window);
+void protocols_reply(void* data, void* reply);
+void sync_counter_reply(void* data, void* reply);
+void button_press_geom(void* data, void* reply);
+void start_drag(xcb_window_t window, enum drag_mode mode,
+                int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t border);
+int32_t client_index(xcb_window_t window);
+void apply_drag(void);
+void note_crossing(unsigned int sequence);
+bool our_crossing(uint32_t sequence);
+void fence_crossings(void);
+void set_wm_state(xcb_window_t window, uint32_t state);
+void set_viewable(struct client_win* client, bool viewable);
+void map_client(struct client_win* client);
+void unmap_client(struct client_win* client);
+bool our_unmap(struct client_win* client, xcb_generic_event_t* ev);
+bool caused_by_us(const xcb_generic_event_t* ev);
+void apply_hover(void);
+void apply_size_hints(xcb_window_t window, uint16_t* w, uint16_t* h);
+void resize_timer_ready(struct loop_source* source, uint32_t events);
+void resize_handled(uint64_t value);
+#ifdef DEBUG
+void check_geometry(void);
+void check_geometry_reply(void* data, void* reply);
+void check_timer_ready(struct loop_source* source, uint32_t events);
+#endif
 void move_window(xcb_drawable_t window, int16_t x, int16_t y);
 void resize_window(xcb_drawable_t window, uint16_t w, uint16_t h);
 void move_resize_window(xcb_drawable_t window, int16_t x, int16_t y, uint16_t w, uint16_t h);
 void configure_request(xcb_configure_request_event_t* e);
+void flush_configures(void);
+void handle_event(xcb_generic_event_t* ev);
+void dispatch(xcb_generic_event_t* ev);
+void end_batch(void);
+void handle_batch(xcb_generic_event_t* ev);
+xcb_generic_event_t* poll_event(bool queued);
+void free_event(xcb_generic_event_t* ev);
+void x_ready(struct loop_source* source, uint32_t events);
+void signal_ready(struct loop_source* source, uint32_t events);
+bool setup_loop(void);
+void listen_ipc(void);
+void write_stats(void);
+void setup_ewmh(void);
+void publish_client_lists(void);
+void raise_window(xcb_window_t window);
+void stacking_changed(xcb_window_t window);
+void list_client(struct client_win* client);
+void want_tile(struct client_win* client);
+void tile_pending(void);
+xcb_window_t window_at(int16_t x, int16_t y);
+xcb_rectangle_t tiling_area(const struct monitor* mon);
+void sync_layouts(void);
+void tile_window(struct client_win* client);
+void untile_window(struct client_win* client);
+void place_window(xcb_window_t window, xcb_rectangle_t rect);
+void apply_layouts(void);
+void switch_workspace(uint32_t n);
+void send_to_workspace(struct client_win* client, uint32_t n);
+void deny_configure(xcb_window_t window);
+const void* ipc_request(const struct ipc_command* cmds, uint32_t n, size_t* len);
+void focus_window(xcb_window_t window);
+void close_window(xcb_window_t window);
+int replay(const char* path);
+void print_stats(FILE* out);
 struct client_win* find_client(xcb_drawable_t window);
 
 /**
@@ -90,25 +311,49 @@ struct client_win* find_client(xcb_drawable_t window);
  */
 
 int main(int argc, char** argv) {
-    // This is to do with window interaction
-    uint32_t values[3];
-
-    xcb_drawable_t win;
     // Root window
     xcb_drawable_t root;
 
     // X event(s)
     xcb_generic_event_t* ev;
-    // ???
-    xcb_get_geometry_reply_t* geom;
-    // For making moving easier
-    xcb_button_press_event_t* bstart;
-    int16_t x = 0, y = 0;
-    uint16_t w = 0, h = 0;
+    xcb_generic_error_t* error;
 
     // For events
     uint32_t not_values[2];
 
+    // Event trace to record, or to replay instead of listening to X
+    const char* record_path = NULL;
+    const char* replay_path = NULL;
+    // State handed down by a restart
+    int snapshot_fd = -1;
+    // Print the statistics when we're done
+#ifdef DEBUG
+    bool exit_stats = true;
+#else
+    bool exit_stats = false;
+#endif
+    int opt;
+
+    while((opt = getopt(argc, argv, "t:r:s:p")) != -1) {
+        switch(opt) {
+        case 't':
+            record_path = optarg;
+            break;
+        case 'r':
+            replay_path = optarg;
+            break;
+        case 's':
+            snapshot_fd = atoi(optarg);
+            break;
+        case 'p':
+            exit_stats = true;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-p] [-t record-trace] [-r replay-trace] [-s snapshot-fd]\n", argv[0]);
+            return 2;
+        }
+    }
+
 
     // Connect to the display
     dpy = xcb_connect(NULL, NULL);
@@ -124,35 +369,13 @@ int main(int argc, char** argv) {
     // Get the root window of the screen
     root = screen->root;
 
-    // Xinerama, for multihead
-#ifdef MULTIHEAD
-    bool xinerama_is_active = false;
-    if(xcb_get_extension_data(dpy, &xcb_xinerama_id)->present) {
-        // Xinerama might actually be there
-        xcb_xinerama_is_active_reply_t* xia = xcb_xinerama_is_active_reply(dpy, xcb_xinerama_is_active(dpy), NULL);
-        if(xia) {
-            xinerama_is_active = xia->state;
-            free(xia);
-        }
-    }
-    if(xinerama_is_active) {
-        // Multihead?
-        xcb_xinerama_query_screens_reply_t* xsq = xcb_xinerama_query_screens_reply(dpy, xcb_xinerama_query_screens(dpy), NULL);
-        xcb_xinerama_screen_info_t* xsi = xcb_xinerama_query_screens_screen_info(xsq);
-        int32_t n = xcb_xinerama_query_screens_screen_info_length(xsq);
-        for(int32_t i = 0; i < n; i++) {
-            xcb_xinerama_screen_info_t info = xsi[i];
-            xcb_rectangle_t rect = (xcb_rectangle_t) {
-                info.x_org, info.y_org, info.width, info.height
-            };
-            // Add monitor or something
-            PDEBUG("%dx%d+%dx%d", rect.x, rect.y, rect.width, rect.height);
-        }
-        free(xsq);
-    } else {
-        PDEBUG("Warning: Xinerama is inactive.");
+    // Monitors, kept current as outputs come and go
+    monitor_init(&monitors, dpy, screen);
+    for(uint32_t i = 0; i < monitors.len; i++) {
+        PDEBUG("Monitor %u: %dx%d+%dx%d", i, monitors.mons[i].x, monitors.mons[i].y,
+               monitors.mons[i].w, monitors.mons[i].h);
     }
-#endif
+    sync_layouts();
 
     // Grab modifiers
     /*xcb_grab_key(dpy, 1, root, MODIFIER_MASK, XCB_NO_SYMBOL,
@@ -169,8 +392,10 @@ int main(int argc, char** argv) {
                     MODIFIER_MASK);
 
     // Do this to the root window so that new windows show up in
-    // XCB_CREATE_NOTIFY, as well as focus events working etc.
-    not_values[0] = XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY
+    // XCB_CREATE_NOTIFY, as well as focus events working etc. Clients
+    // configuring and mapping their windows have to go through us.
+    not_values[0] = XCB_EVENT_MASK_SUBSTRUCTURE_REDIRECT
+                    | XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY
                     | XCB_EVENT_MASK_EXPOSURE
                     | XCB_EVENT_MASK_BUTTON_PRESS
                     | XCB_EVENT_MASK_KEY_PRESS
@@ -178,321 +403,2177 @@ int main(int argc, char** argv) {
                     | XCB_EVENT_MASK_LEAVE_WINDOW
                     | XCB_EVENT_MASK_FOCUS_CHANGE
                     | XCB_EVENT_MASK_PROPERTY_CHANGE;
-    xcb_change_window_attributes_checked(dpy, root, XCB_CW_EVENT_MASK, not_values);
+    for(int tries = 0; ; tries++) {
+        error = stats_reply(xcb_request_check(dpy, xcb_change_window_attributes_checked(dpy, root,
+                                              XCB_CW_EVENT_MASK, not_values)));
+        stats.roundtrips++;
+        // Restarting, the server may not be done with the old us yet
+        if(error == NULL || snapshot_fd < 0 || tries == 100) {
+            break;
+        }
+        stats_reply_free(error);
+        usleep(10000);
+    }
+    if(error != NULL) {
+        // Only one client gets to redirect the root's children
+        fprintf(stderr, "Another window manager is already running!\n");
+        stats_reply_free(error);
+        unhide_snapshot(snapshot_fd);
+        xcb_disconnect(dpy);
+        return 1;
+    }
 
-    xcb_flush(dpy);
+    // Everything we'll ever need, in one round trip
+    if(!atoms_init(dpy)) {
+        fprintf(stderr, "Couldn't intern atoms!\n");
+        unhide_snapshot(snapshot_fd);
+        xcb_disconnect(dpy);
+        return 1;
+    }
 
-    // Main loop
-    // while(true), essentially
-    for(;;) {
-        // Wait for next event from XCB
-        ev = xcb_wait_for_event(dpy);
-        // Magic?
-        switch(ev->response_type & ~0x80) {
-        // Button pressed
-        case XCB_BUTTON_PRESS: {
-            // Button press event.
-            xcb_button_press_event_t *e;
-            // Typecast obv.
-            e = (xcb_button_press_event_t*) ev;
-
-            // Get clicked window
-            win = e->child;
-            // Stacking
-            values[0] = XCB_STACK_MODE_ABOVE;
-            // Get geometry and stuff from interacting with the window
-            xcb_configure_window(dpy, win, XCB_CONFIG_WINDOW_STACK_MODE, values);
-            geom = xcb_get_geometry_reply(dpy, xcb_get_geometry(dpy, win), NULL);
-            // Move mouse pointer as needed
-            if(e->detail == 1) {
-                values[2] = 1;
-                xcb_warp_pointer(dpy, XCB_NONE, win, 0, 0, 0, 0, 1, 1);
-            } else {
-                values[2] = 3;
-                xcb_warp_pointer(dpy, XCB_NONE, win, 0, 0, 0, 0, geom->width, geom->height);
-            }
-            // Grab for necessary events
-            xcb_grab_pointer(dpy, 0, root, XCB_EVENT_MASK_BUTTON_RELEASE |
-                             XCB_EVENT_MASK_BUTTON_MOTION | XCB_EVENT_MASK_POINTER_MOTION_HINT,
-                             XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC, root, XCB_NONE, XCB_CURRENT_TIME);
-            // Flush
-            bstart = e;
-            get_geom(win, &x, &y, &w, &h);
-            xcb_flush(dpy);
-        }
-        break;
-        // Mouse moved
-        case XCB_MOTION_NOTIFY: {
-            xcb_query_pointer_reply_t *pointer;
-            pointer = xcb_query_pointer_reply(dpy, xcb_query_pointer(dpy, root), 0);
-            // Window movement
-            if(values[2] == MOVE_MOUSE_BUTTON) {
-                int32_t xdiff = pointer->root_x - bstart->root_x;
-                int32_t ydiff = pointer->root_y - bstart->root_y;
-                move_window(win, bstart->root_x + xdiff, bstart->root_y + ydiff);
-            }
-            // Window resizing
-            else if(values[2] == RESIZE_MOUSE_BUTTON) {
-                geom = xcb_get_geometry_reply(dpy, xcb_get_geometry(dpy, win), NULL);
-                if(!(pointer->root_x <= geom->x || pointer->root_y <= geom->y)) {
-                    values[0] = pointer->root_x - geom->x;
-                    values[1] = pointer->root_y - geom->y;
-                    if(values[0] >= MIN_WINDOW_SIZE && values[1] >= MIN_WINDOW_SIZE) {
-                        resize_window(win, values[0], values[1]);
-                    }
-                }
-            }
-        }
-        break;
-        // Mouse released
-        case XCB_BUTTON_RELEASE:
-            // Return the pointer
-            xcb_ungrab_pointer(dpy, XCB_CURRENT_TIME);
-            xcb_flush(dpy);
-            break;
-        // Window wants to be mapped
-        case XCB_MAP_REQUEST: {
-            xcb_map_request_event_t *e;
+    // For clients that tell us when they're done resizing
+    xsync_init(&xsync, dpy);
 
-            PDEBUG("event: Map request");
-            e = (xcb_map_request_event_t*) ev;
-            new_window(e->window);
+    if(snapshot_fd >= 0) {
+        if(snapshot_read(&snapshot, snapshot_fd)) {
+            workspace = snapshot.header.workspace < WORKSPACES ? snapshot.header.workspace : 0;
+        } else {
+            PDEBUG("Couldn't read the snapshot, starting from scratch");
         }
-        break;
-        case XCB_CREATE_NOTIFY: {
-            xcb_create_notify_event_t *e;
+    }
 
-            PDEBUG("event: Create notify");
-            e = (xcb_create_notify_event_t*) ev;
-            new_window(e->window);
-        }
-        break;
-        case XCB_DESTROY_NOTIFY: {
-            PDEBUG("event: destroy notification");
-            xcb_destroy_notify_event_t *e;
+    setup_ewmh();
+
+    // Manage whatever was already there before we started. Without
+    // the snapshot a restart meant to pass on, its hidden windows have
+    // to be found some other way.
+    adopt_windows(snapshot_fd >= 0 && snapshot.clients == NULL);
+    restore_order();
+    snapshot_free(&snapshot);
+    tile_pending();
+    apply_layouts();
+    map_pending();
+
+    publish_client_lists();
+    fence_crossings();
+    stats_flush(dpy);
+    async_resolve(&replies, dpy);
+
+    if(replay_path) {
+        return replay(replay_path);
+    }
+    if(record_path && !trace_create(&recording, record_path)) {
+        fprintf(stderr, "Couldn't create trace %s!\n", record_path);
+        return 1;
+    }
+    if(!setup_loop()) {
+        perror("qtwm: setting up the main loop");
+        return 1;
+    }
 
-            e = (xcb_destroy_notify_event_t*) ev;
-            // Adjust window focus maybe?
-            // Forget about this windodw
-            forgetwindow(e->window);
-            xcb_flush(dpy);
-        }
-        break;
-        case XCB_CONFIGURE_REQUEST: {
-            configure_request((xcb_configure_request_event_t*) ev);
-        }
-        break;
-        case XCB_ENTER_NOTIFY:
-        case XCB_LEAVE_NOTIFY: {
-            int32_t response_type = ev->response_type & ~0x80;
-
-            if(response_type == XCB_ENTER_NOTIFY) {
-                xcb_enter_notify_event_t* e = (xcb_enter_notify_event_t*) ev;
-                set_border_color(e->event, true);
-                PDEBUG("Focusing on a window!");
-            } else if(response_type == XCB_LEAVE_NOTIFY) {
-                xcb_leave_notify_event_t* e = (xcb_leave_notify_event_t*) ev;
-                set_border_color(e->event, false);
-                PDEBUG("Unfocusing on a window!");
-            }
-        }
-        break;
+    // Main loop. Sleeps until X, a timer or a signal wants something.
+    while(loop.running) {
+        // Waiting for a reply reads any events in front of it off the
+        // socket, and then epoll won't tell us about them
+        if((ev = poll_event(true)) != NULL) {
+            handle_batch(ev);
+            continue;
         }
-        free(ev);
-        if(xcb_connection_has_error(dpy)) {
-            fprintf(stderr, "XCB connection has encountered an error, exiting...");
+        if(loop_wait(&loop, -1) < 0) {
+            perror("qtwm: waiting for events");
             break;
         }
+        // Send whatever the other sources asked for
+        fence_crossings();
+        stats_flush(dpy);
+        // Only comes back if it didn't work out, and then we carry on
+        if(restarting) {
+            restarting = false;
+            restart(argv);
+        }
     }
+    trace_close(&recording);
+    // Not on a connection that's gone
+    if(exit_stats && !xcb_connection_has_error(dpy)) {
+        print_stats(stderr);
+    }
+    ipc_close(&ipc);
+    loop_free(&loop);
     xcb_disconnect(dpy);
     return 0;
 }
 
-void new_window(xcb_window_t window) {
-    // Figure out what window we're placing
-    struct client_win* client;
-    /*
-     * If we already manage this window, skip. There's probably a good reason for why.
-     */
-    if(find_client(window)) {
-        return;
-    }
+/*
+ * Watch the X connection, and take the signals we care about through
+ * the loop rather than handlers.
+ */
+bool setup_loop(void) {
+    sigset_t mask;
 
-    client = setup_window(window);
-    if(client == NULL) {
-        PDEBUG("Couldn't set up window: Out of memory!");
-        return;
+    if(!loop_init(&loop)) {
+        return false;
     }
-    // Determine if it needs to be remapped or not.
-    // Set up borders/etc., add to list of managed windows
-    // xcb_map_window(connection, id)
-    xcb_map_window(dpy, client->id);
-    // "Declare window normal"? Some ICCCM thing it looks like
-    // Move pointer as necessary
 
-    // xcb_flush(conn);
-    xcb_flush(dpy);
-}
+    x_source.fd = xcb_get_file_descriptor(dpy);
+    x_source.cb = x_ready;
+    x_source.data = NULL;
+    if(!loop_add(&loop, &x_source, EPOLLIN)) {
+        return false;
+    }
 
-struct client_win* setup_window(xcb_window_t window) {
-    uint32_t values[2];
-    uint32_t mask = 0;
-    struct item* item;
-    struct client_win* client;
+    // SIGUSR1 dumps statistics, SIGHUP restarts, the rest are a clean
+    // exit
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGUSR1);
+    sigaddset(&mask, SIGTERM);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGHUP);
+    if(!loop_signal_init(&signal_source, &mask, signal_ready, NULL)
+            || !loop_add(&loop, &signal_source, EPOLLIN)) {
+        return false;
+    }
 
-    // Set border color
-    set_border_color(window, false);
-    set_border_width(window);
+#ifdef DEBUG
+    if(!loop_timer_init(&check_timer, check_timer_ready, NULL)
+            || !loop_add(&loop, &check_timer, EPOLLIN)) {
+        return false;
+    }
+    loop_timer_arm(&check_timer, GEOM_CHECK_INTERVAL_MS * 1000000ull,
+                   GEOM_CHECK_INTERVAL_MS * 1000000ull);
+#endif
 
-    mask = XCB_CW_EVENT_MASK;
-    values[0] = XCB_EVENT_MASK_ENTER_WINDOW
-                | XCB_EVENT_MASK_FOCUS_CHANGE
-                | XCB_EVENT_MASK_LEAVE_WINDOW
-                | XCB_EVENT_MASK_PROPERTY_CHANGE;
-    xcb_change_window_attributes(dpy, window, mask, values);
+    if(!loop_timer_init(&resize_timer, resize_timer_ready, NULL)
+            || !loop_add(&loop, &resize_timer, EPOLLIN)) {
+        return false;
+    }
 
-    // Add this window to the X Save Set
-    xcb_change_save_set(dpy, XCB_SET_MODE_INSERT, window);
+    listen_ipc();
 
-    xcb_flush(dpy);
+    return true;
+}
 
-    // Remember window and store a few things about it
+/*
+ * Open the control socket. Not worth dying over.
+ */
+void listen_ipc(void) {
+    char path[108];
+    char dir[96];
+    const char* display = getenv("DISPLAY");
+
+    snprintf(path, sizeof(path), IPC_SOCKET, ipc_dir(dir, sizeof(dir)), display ? display : "");
+    if(!ipc_listen(&ipc, &loop, path, ipc_request)) {
+        perror("qtwm: control socket");
+    }
+}
 
-    item = additem(&winlist);
+/*
+ * The X connection is readable: handle everything that's there.
+ */
+void x_ready(struct loop_source* source, uint32_t events) {
+    xcb_generic_event_t* ev = poll_event(false);
 
-    if(item == NULL) {
-        PDEBUG("Out of memory!");
-        return NULL;
+    if(ev != NULL) {
+        handle_batch(ev);
     }
-
-    client = malloc(sizeof(struct client_win));
-    if(client == NULL) {
-        PDEBUG("Out of memory!");
-        return NULL;
+    if(xcb_connection_has_error(dpy)) {
+        fprintf(stderr, "XCB connection has encountered an error, exiting...");
+        loop_stop(&loop);
     }
+}
 
-    item->data = client;
+/*
+ * Next event there is without blocking, or NULL. With queued, only
+ * those already read off the connection. It counts as live until
+ * free_event().
+ */
+xcb_generic_event_t* poll_event(bool queued) {
+    xcb_generic_event_t* ev = queued ? xcb_poll_for_queued_event(dpy) : xcb_poll_for_event(dpy);
 
-    // Initialize client
-    client->id = window;
-    client->x = 0;
-    client->y = 0;
-    client->w = 0;
-    client->h = 0;
-    client->window_item = item;
-
-    // Get geometry, store in client
-    if(!get_geom(window, &client->x, &client->y, &client->w, &client->h)) {
-        PDEBUG("Couldn't get geometry for initial window setup!");
+    if(ev != NULL) {
+        stats_alloc(STATS_MEM_EVENTS);
     }
-
-    // ICCCM nonsense would go here.
-
-    return client;
+    return ev;
 }
 
-void set_border_color(xcb_window_t window, bool focus) {
-    uint32_t values[1];
-    values[0] = focus ? BORDER_COLOR_FOCUSED : BORDER_COLOR_UNFOCUSED;
-    xcb_change_window_attributes(dpy, window, XCB_CW_BORDER_PIXEL, values);
-    xcb_flush(dpy);
+void free_event(xcb_generic_event_t* ev) {
+    free(ev);
+    stats_free(STATS_MEM_EVENTS);
 }
 
-void set_border_width(xcb_window_t window) {
-    uint32_t values[1];
-    values[0] = BORDER_WIDTH;
-    xcb_configure_window(dpy, window, XCB_CONFIG_WINDOW_BORDER_WIDTH, values);
-    xcb_flush(dpy);
+/*
+ * Handle ev and every other event there is without blocking, then send
+ * all of our requests in one go.
+ */
+void handle_batch(xcb_generic_event_t* ev) {
+    do {
+        dispatch(ev);
+        free_event(ev);
+    } while((ev = poll_event(false)) != NULL);
+    end_batch();
 }
 
-void forgetwindow(xcb_window_t window) {
-    struct item* item;
-    struct client_win* client;
-
-    for(item = winlist; item != NULL; item = item->next) {
-        client = item->data;
-        if(window == client->id) {
-            PDEBUG("Found client. Forgetting...");
-
-            // Workspaces (as needed)
-
-            free(item->data);
-            delitem(&winlist, item);
+void signal_ready(struct loop_source* source, uint32_t events) {
+    int sig;
+
+    while((sig = loop_signal_read(source)) != 0) {
+        if(sig == SIGUSR1) {
+            write_stats();
+        } else if(sig == SIGHUP) {
+            PDEBUG("Got SIGHUP, restarting");
+            restarting = true;
+        } else {
+            PDEBUG("Got signal %d, exiting", sig);
+            loop_stop(&loop);
         }
     }
 }
 
-bool get_geom(xcb_drawable_t window, int16_t* x, int16_t* y, uint16_t* w, uint16_t* h) {
-    xcb_get_geometry_reply_t* geom;
-
-    geom = xcb_get_geometry_reply(dpy, xcb_get_geometry(dpy, window), NULL);
-    if(geom == NULL) {
-        PDEBUG("Unable to get window geometry!");
-        return false;
+/*
+ * Handle one event, timing it and recording it if asked to.
+ */
+void dispatch(xcb_generic_event_t* ev) {
+    uint8_t type = ev->response_type & ~0x80;
+    struct stats_mark mark;
+
+    // Events come in request order: past the last of ours, there are
+    // no more crossings of ours to come
+    if(ours.from != 0 && (int32_t) (ev->full_sequence - ours.to) > 0) {
+        ours.from = 0;
     }
-    PDEBUG("Got geometry: %dx%d+%dx%d", geom->x, geom->y, geom->width, geom->height)
+    if(recording.file) {
+        trace_write(&recording, ev, (uint32_t) stats.batches, caused_by_us(ev) ? TRACE_OURS : 0);
+    }
+    mark = stats_begin();
+    handle_event(ev);
+    stats_end_event(type, mark);
+}
 
-    *x = geom->x;
-    *y = geom->y;
-    *w = geom->width;
-    *h = geom->height;
+/*
+ * Everything that happens once per batch of events, after they have
+ * all been handled.
+ */
+void end_batch(void) {
+    struct stats_mark mark = stats_begin();
+
+    // Only the newest pointer position of the batch matters
+    apply_drag();
+    // Windows that asked to be mapped, unless they're dialogs
+    tile_pending();
+    // Tiled windows go where the batch's changes put them
+    apply_layouts();
+    // Likewise only the end result of each window's ConfigureRequests
+    flush_configures();
+    // Only now that they're in place, show the windows that asked
+    map_pending();
+    // And only where the pointer ended up
+    apply_hover();
+    // And of the batch's changes to the window lists
+    publish_client_lists();
+    // Collect the replies to everything asked in one round trip.
+    // Waiting for them puts our requests on the wire anyway.
+    if(replies.len > 0) {
+        stats_flush(dpy);
+        async_resolve(&replies, dpy);
+    }
+    fence_crossings();
+    stats_flush(dpy);
+    stats_end_batch(mark);
 
-    free(geom);
+    if(recording.file) {
+        trace_sync(&recording);
+    }
+}
 
-    return true;
+void write_stats(void) {
+    const char* display = getenv("DISPLAY");
+    char path[108];
+    char dir[96];
+    FILE* out = NULL;
+    int fd = -1;
+
+    snprintf(path, sizeof(path), STATS_FILE, ipc_dir(dir, sizeof(dir)), display ? display : "");
+    // Not following whatever someone else may have put there
+    if(ipc_private_dir(path)) {
+        fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW | O_CLOEXEC, 0600);
+    }
+    if(fd >= 0 && (out = fdopen(fd, "w")) == NULL) {
+        close(fd);
+    }
+    if(out) {
+        print_stats(out);
+        fclose(out);
+    } else {
+        PDEBUG("Couldn't open %s for statistics!", path);
+    }
 }
 
-void move_window(xcb_drawable_t window, int16_t x, int16_t y) {
-    uint32_t values[2] = { x, y };
-    PDEBUG("Moving window to (%d %d)", x, y);
-    xcb_configure_window(dpy, window, XCB_MOVE, values);
-    xcb_flush(dpy);
+/*
+ * Feed a recorded trace through the handlers as fast as they take it,
+ * batched the way it was recorded. Window IDs in the trace mostly don't
+ * exist on this server, so whatever it sends back is thrown away; the
+ * point is the statistics printed at the end.
+ */
+int replay(const char* path) {
+    struct trace trace;
+    struct trace_record record;
+    xcb_generic_event_t ev;
+    xcb_generic_event_t* junk;
+    uint32_t batch = 0;
+    bool pending = false;
+    uint64_t start;
+
+    if(!trace_open(&trace, path)) {
+        fprintf(stderr, "Couldn't open trace %s!\n", path);
+        return 1;
+    }
+
+    // Our requests now aren't the ones made while recording, so which
+    // events they caused comes from the trace
+    replaying = true;
+    start = stats_now();
+    while(trace_read(&trace, &record)) {
+        if(pending && record.batch != batch) {
+            end_batch();
+            while((junk = poll_event(false)) != NULL) {
+                free_event(junk);
+            }
+        }
+        batch = record.batch;
+        pending = true;
+
+        memset(&ev, 0, sizeof(ev));
+        memcpy(&ev, record.event, TRACE_EVENT_SIZE);
+        ev.full_sequence = record.sequence;
+        replayed_ours = record.flags & TRACE_OURS;
+        dispatch(&ev);
+    }
+    if(pending) {
+        end_batch();
+    }
+    trace_close(&trace);
+
+    fprintf(stderr, "Replayed %llu events in %.3f ms\n",
+            (unsigned long long) stats.events, (stats_now() - start) / 1e6);
+    print_stats(stderr);
+    xcb_disconnect(dpy);
+    return 0;
 }
 
-void resize_window(xcb_drawable_t window, uint16_t w, uint16_t h) {
-    uint32_t values[2] = { w, h };
-    PDEBUG("Resizing window to (%d, %d)!", w, h);
-    xcb_configure_window(dpy, window, XCB_RESIZE, values);
-    xcb_flush(dpy);
+/*
+ * Tell EWMH clients that we're here and what we do.
+ */
+void setup_ewmh(void) {
+    xcb_window_t check = xcb_generate_id(dpy);
+    xcb_atom_t supported[] = {
+        atoms[ATOM__NET_SUPPORTED],
+        atoms[ATOM__NET_SUPPORTING_WM_CHECK],
+        atoms[ATOM__NET_WM_NAME],
+        atoms[ATOM__NET_CLIENT_LIST],
+        atoms[ATOM__NET_CLIENT_LIST_STACKING],
+        atoms[ATOM__NET_NUMBER_OF_DESKTOPS],
+        atoms[ATOM__NET_CURRENT_DESKTOP],
+        atoms[ATOM__NET_WM_SYNC_REQUEST]
+    };
+    uint32_t desktops = WORKSPACES;
+    // Or our own CreateNotify would have us manage it
+    uint32_t override = 1;
+
+    client_list.atom = atoms[ATOM__NET_CLIENT_LIST];
+    stacking_list.atom = atoms[ATOM__NET_CLIENT_LIST_STACKING];
+
+    // The check window proves the root's properties aren't stale
+    xcb_create_window(dpy, XCB_COPY_FROM_PARENT, check, screen->root, -1, -1, 1, 1, 0,
+                      XCB_WINDOW_CLASS_INPUT_ONLY, XCB_COPY_FROM_PARENT, XCB_CW_OVERRIDE_REDIRECT, &override);
+    xcb_change_property(dpy, XCB_PROP_MODE_REPLACE, check, atoms[ATOM__NET_SUPPORTING_WM_CHECK],
+                        XCB_ATOM_WINDOW, 32, 1, &check);
+    xcb_change_property(dpy, XCB_PROP_MODE_REPLACE, check, atoms[ATOM__NET_WM_NAME],
+                        atoms[ATOM_UTF8_STRING], 8, strlen("qtwm"), "qtwm");
+    xcb_change_property(dpy, XCB_PROP_MODE_REPLACE, screen->root, atoms[ATOM__NET_SUPPORTING_WM_CHECK],
+                        XCB_ATOM_WINDOW, 32, 1, &check);
+    xcb_change_property(dpy, XCB_PROP_MODE_REPLACE, screen->root, atoms[ATOM__NET_SUPPORTED],
+                        XCB_ATOM_ATOM, 32, sizeof(supported) / sizeof(supported[0]), supported);
+    xcb_change_property(dpy, XCB_PROP_MODE_REPLACE, screen->root, atoms[ATOM__NET_NUMBER_OF_DESKTOPS],
+                        XCB_ATOM_CARDINAL, 32, 1, &desktops);
+    xcb_change_property(dpy, XCB_PROP_MODE_REPLACE, screen->root, atoms[ATOM__NET_CURRENT_DESKTOP],
+                        XCB_ATOM_CARDINAL, 32, 1, &workspace);
 }
 
-void move_resize_window(xcb_drawable_t window, int16_t x, int16_t y, uint16_t w, uint16_t h) {
-    uint32_t values[4] = { x, y, w, h };
-    PDEBUG("Changing geometry to %dx%d+%dx%d!", x, y, w, h);
-    xcb_configure_window(dpy, window, XCB_MOVE_RESIZE, values);
-    xcb_flush(dpy);
+/*
+ * Bring _NET_CLIENT_LIST and _NET_CLIENT_LIST_STACKING up to date. At
+ * most once per batch, so a storm of new windows is one PropertyNotify
+ * each for the panels, not one per window.
+ */
+void publish_client_lists(void) {
+    clientlist_flush(&client_list, dpy, screen->root);
+    clientlist_flush(&stacking_list, dpy, screen->root);
 }
 
-void configure_request(xcb_configure_request_event_t* e) {
-    struct client_win* client;
+/*
+ * Carry out a batch of control commands. Nothing reaches the server
+ * until all of them are done, and then it all goes in one flush.
+ */
+const void* ipc_request(const struct ipc_command* cmds, uint32_t n, size_t* len) {
+    struct ipc_reply reply = { 0, 0, 0, 0 };
+    bool list = false;
+    size_t need;
+
+    for(uint32_t i = 0; i < n; i++) {
+        const struct ipc_command* cmd = &cmds[i];
+
+        if(cmd->op == IPC_LIST) {
+            list = true;
+            reply.done++;
+            continue;
+        }
+        if(cmd->op == IPC_WORKSPACE) {
+            if((uint16_t) cmd->x < WORKSPACES) {
+                switch_workspace((uint16_t) cmd->x);
+                reply.done++;
+            } else {
+                reply.failed++;
+            }
+            continue;
+        }
+        if(find_client(cmd->window) == NULL) {
+            reply.failed++;
+            continue;
+        }
+        switch(cmd->op) {
+        case IPC_MOVE:
+            move_window(cmd->window, cmd->x, cmd->y);
+            break;
+        case IPC_RESIZE:
+            resize_window(cmd->window, cmd->w, cmd->h);
+            break;
+        case IPC_MOVE_RESIZE:
+            move_resize_window(cmd->window, cmd->x, cmd->y, cmd->w, cmd->h);
+            break;
+        case IPC_FOCUS:
+            focus_window(cmd->window);
+            break;
+        case IPC_CLOSE:
+            close_window(cmd->window);
+            break;
+        case IPC_SEND_TO_WORKSPACE:
+            if((uint16_t) cmd->x >= WORKSPACES) {
+                reply.failed++;
+                continue;
+            }
+            send_to_workspace(find_client(cmd->window), (uint16_t) cmd->x);
+            break;
+        default:
+            reply.failed++;
+            continue;
+        }
+        reply.done++;
+    }
+    apply_layouts();
+    publish_client_lists();
+    stats_flush(dpy);
 
-    if((client = find_client(e->window))) {
-        PDEBUG("X asked us to configure a window. We should implement that at some point.");
-        PDEBUG("configure_request: Not implemented");
-        // Configurations. Taken from looking at mcwm again.
-        //
-        // XCB_CONFIG_WINDOW_WIDTH
-        // XCB_CONFIG_WINDOW_HEIGHT
-        // XCB_CONFIG_WINDOW_SIBLING
-        // XCB_CONFIG_WINDOW_STACK_MODE
-    } else {
-        // Unmapped window
-        PDEBUG("X requested that we configure a window we don't know about yet!");
+    // Listed after the commands, so it shows what they did
+    if(list) {
+        reply.clients = store.len;
+    }
+    need = sizeof(reply) + reply.clients * sizeof(struct ipc_client);
+    if(need > ipc_reply_cap) {
+        uint8_t* buf = realloc(ipc_reply, need);
+
+        if(buf == NULL) {
+            // Still say how the commands went
+            reply.clients = 0;
+            need = sizeof(reply);
+        } else {
+            ipc_reply = buf;
+            ipc_reply_cap = need;
+        }
+    }
+    if(ipc_reply == NULL) {
+        *len = 0;
+        return NULL;
+    }
+    memcpy(ipc_reply, &reply, sizeof(reply));
+    for(uint32_t i = 0; i < reply.clients; i++) {
+        struct ipc_client* client = (struct ipc_client*) (ipc_reply + sizeof(reply)) + i;
+
+        client->window = store.ids[i];
+        client->x = store.x[i];
+        client->y = store.y[i];
+        client->w = store.w[i];
+        client->h = store.h[i];
+        client->border = store.border[i];
+        client->pad = 0;
     }
+    *len = need;
+
+    return ipc_reply;
 }
 
-struct client_win* find_client(xcb_drawable_t window) {
-    struct client_win* win;
-    struct item* item;
+void print_stats(FILE* out) {
+    stats_print(out, dpy);
+    pool_print(out, "clients", &client_pool);
+    props_print(out, &properties);
+}
 
-    for(item = winlist; item != NULL; item = item->next) {
-        win = item->data;
-        if(win->id == window) {
-            PDEBUG("Found client");
-            return win;
+void handle_event(xcb_generic_event_t* ev) {
+    // Magic?
+    switch(ev->response_type & ~0x80) {
+    // Button pressed
+    case XCB_BUTTON_PRESS: {
+        // Button press event.
+        xcb_button_press_event_t *e;
+        xcb_get_geometry_cookie_t cookie;
+        struct client_win* client;
+        enum drag_mode mode;
+        int32_t i;
+        // Typecast obv.
+        e = (xcb_button_press_event_t*) ev;
+
+        // Get clicked window
+        if(e->child == XCB_NONE) {
+            break;
+        }
+        mode = e->detail == MOVE_MOUSE_BUTTON ? DRAG_MOVE : DRAG_RESIZE;
+        pointer_x = e->root_x;
+        pointer_y = e->root_y;
+        // Stacking
+        raise_window(e->child);
+        client = find_client(e->child);
+        if(client != NULL && client->layout != NULL) {
+            // Tiled windows stay where the layout puts them
+            break;
+        }
+        if((i = client_index(e->child)) >= 0) {
+            // We already know where our own windows are
+            start_drag(e->child, mode, store.x[i], store.y[i], store.w[i], store.h[i], store.border[i]);
+        } else {
+            // The drag starts once we know where the window is
+            press.window = e->child;
+            press.mode = mode;
+            cookie = xcb_get_geometry(dpy, press.window);
+            async_push(&replies, dpy, cookie.sequence, button_press_geom, NULL);
+        }
+        // Grab for necessary events. No motion hints: every motion
+        // event carries the pointer position, so we never have to ask.
+        xcb_grab_pointer(dpy, 0, screen->root, XCB_EVENT_MASK_BUTTON_RELEASE |
+                         XCB_EVENT_MASK_BUTTON_MOTION,
+                         XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC, screen->root, XCB_NONE, XCB_CURRENT_TIME);
+    }
+    break;
+    // Mouse moved
+    case XCB_MOTION_NOTIFY: {
+        xcb_motion_notify_event_t* e = (xcb_motion_notify_event_t*) ev;
+
+        // Applied once the whole batch is handled
+        drag_motion(&drag, e->root_x, e->root_y);
+        pointer_x = e->root_x;
+        pointer_y = e->root_y;
+    }
+    break;
+    // Mouse released
+    case XCB_BUTTON_RELEASE:
+        // Wherever the pointer ended up is where the window goes,
+        // caught up with or not
+        drag_ready(&drag);
+        apply_drag();
+        // Return the pointer
+        press.window = XCB_NONE;
+        drag_end(&drag);
+        xsync_unwatch(&xsync, dpy);
+        loop_timer_arm(&resize_timer, 0, 0);
+        xcb_ungrab_pointer(dpy, XCB_CURRENT_TIME);
+        break;
+    // Window wants to be mapped
+    case XCB_MAP_REQUEST: {
+        xcb_map_request_event_t *e;
+        struct client_win* client;
+
+        PDEBUG("event: Map request");
+        e = (xcb_map_request_event_t*) ev;
+        // Maps are redirected to us now, even for windows we know
+        client = new_window(e->window);
+        if(client == NULL) {
+            // Unmanaged, but it still gets to show
+            note_crossing(xcb_map_window(dpy, e->window).sequence);
+            break;
+        }
+        list_client(client);
+        // Only what asks to be mapped gets tiled; popups never ask
+        if(client->layout == NULL) {
+            want_tile(client);
+        }
+        // Not before the layout has put it in place
+        if(!stack_push(&pending_maps, e->window)) {
+            map_client(client);
+        }
+    }
+    break;
+    case XCB_CREATE_NOTIFY: {
+        xcb_create_notify_event_t *e;
+
+        PDEBUG("event: Create notify");
+        e = (xcb_create_notify_event_t*) ev;
+        // New windows start out on top
+        if(e->parent == screen->root) {
+            stack_push(&stack, e->window);
+        }
+        // Menus and tooltips look after themselves
+        if(e->override_redirect) {
+            break;
         }
+        new_window(e->window);
     }
+    break;
+    case XCB_MAP_NOTIFY: {
+        xcb_map_notify_event_t* e = (xcb_map_notify_event_t*) ev;
+        struct client_win* client = find_client(e->window);
 
-    return NULL;
+        if(client != NULL) {
+            set_viewable(client, true);
+        }
+    }
+    break;
+    case XCB_UNMAP_NOTIFY: {
+        xcb_unmap_notify_event_t* e = (xcb_unmap_notify_event_t*) ev;
+        struct client_win* client = find_client(e->window);
+
+        if(client == NULL) {
+            break;
+        }
+        set_viewable(client, false);
+        // One of ours, from hiding a workspace
+        if(our_unmap(client, ev)) {
+            break;
+        }
+        // The client withdrew the window
+        PDEBUG("event: window withdrawn");
+        set_wm_state(e->window, WM_STATE_WITHDRAWN);
+        forgetwindow(e->window);
+    }
+    break;
+    case XCB_CLIENT_MESSAGE: {
+        xcb_client_message_event_t* e = (xcb_client_message_event_t*) ev;
+
+        // Pagers asking to switch
+        if(e->type == atoms[ATOM__NET_CURRENT_DESKTOP] && e->format == 32) {
+            switch_workspace(e->data.data32[0]);
+        }
+    }
+    break;
+    case XCB_DESTROY_NOTIFY: {
+        PDEBUG("event: destroy notification");
+        xcb_destroy_notify_event_t *e;
+
+        e = (xcb_destroy_notify_event_t*) ev;
+        // Adjust window focus maybe?
+        // Forget about this windodw
+        stack_remove(&stack, e->window);
+        forgetwindow(e->window);
+    }
+    break;
+    case XCB_REPARENT_NOTIFY: {
+        xcb_reparent_notify_event_t* e = (xcb_reparent_notify_event_t*) ev;
+
+        // Reparenting puts a window on top of its new siblings
+        if(e->parent == screen->root) {
+            stack_push(&stack, e->window);
+        } else {
+            stack_remove(&stack, e->window);
+            // Someone else's now, say embedded in a tray; we won't
+            // hear of it being destroyed
+            forgetwindow(e->window);
+        }
+    }
+    break;
+    case XCB_CONFIGURE_REQUEST: {
+        configure_request((xcb_configure_request_event_t*) ev);
+    }
+    break;
+    case XCB_CONFIGURE_NOTIFY: {
+        xcb_configure_notify_event_t* e = (xcb_configure_notify_event_t*) ev;
+        int32_t i;
+
+        // Whoever changed it, this is where the window is now
+        if((i = client_index(e->window)) >= 0) {
+            store_set_geom(&store, i, e->x, e->y, e->width, e->height);
+            store_set_border(&store, i, e->border_width);
+        }
+        // And what it's on top of; no sibling means the bottom
+        if(e->event == screen->root && stack_place(&stack, e->window, e->above_sibling,
+                e->above_sibling == XCB_NONE ? XCB_STACK_MODE_BELOW : XCB_STACK_MODE_ABOVE)) {
+            stacking_changed(e->window);
+        }
+    }
+    break;
+    case XCB_PROPERTY_NOTIFY: {
+        xcb_property_notify_event_t* e = (xcb_property_notify_event_t*) ev;
+
+        // Cached ones are only fetched again when they're next needed
+        if(props_changed(&properties, e->window, e->atom)) {
+            break;
+        }
+        if((e->atom == atoms[ATOM_WM_PROTOCOLS] || e->atom == atoms[ATOM__NET_WM_SYNC_REQUEST_COUNTER])
+                && find_client(e->window)) {
+            get_protocols(e->window);
+        }
+    }
+    break;
+    case XCB_ENTER_NOTIFY:
+    case XCB_LEAVE_NOTIFY: {
+        // Same layout for both
+        xcb_enter_notify_event_t* e = (xcb_enter_notify_event_t*) ev;
+
+        pointer_x = e->root_x;
+        pointer_y = e->root_y;
+        // Grabs, and windows moving under a pointer that stayed put,
+        // aren't the user pointing at anything
+        if(e->mode != XCB_NOTIFY_MODE_NORMAL) {
+            stats.crossings_ignored++;
+            break;
+        }
+        if(our_crossing(ev->full_sequence)) {
+            // Worked out from our stacking order instead
+            hover_stale = true;
+            stats.crossings_ignored++;
+            break;
+        }
+        // Only noted; the batch's last word is applied at its end
+        if((ev->response_type & ~0x80) == XCB_ENTER_NOTIFY) {
+            hover = find_client(e->event) ? e->event : XCB_NONE;
+        } else if(e->event == hover && e->detail != XCB_NOTIFY_DETAIL_INFERIOR) {
+            hover = XCB_NONE;
+        }
+    }
+    break;
+    default: {
+        uint64_t value;
+
+        // Extension events have no fixed type
+        if(xsync_event(&xsync, ev, &value)) {
+            resize_handled(value);
+        } else if(monitor_event(&monitors, screen, ev)) {
+            PDEBUG("Monitors changed, now %u", monitors.len);
+            sync_layouts();
+        }
+    }
+    break;
+    }
+}
+
+/*
+ * Manage window, if we don't already. It isn't mapped until it asks.
+ * Returns its client, or NULL if out of memory.
+ */
+struct client_win* new_window(xcb_window_t window) {
+    // Figure out what window we're placing
+    struct client_win* client;
+    /*
+     * If we already manage this window, skip. There's probably a good reason for why.
+     */
+    if((client = find_client(window)) != NULL) {
+        return client;
+    }
+
+    client = setup_window(window, NULL);
+    if(client == NULL) {
+        PDEBUG("Couldn't set up window: Out of memory!");
+        return NULL;
+    }
+    // "Declare window normal"? Some ICCCM thing it looks like
+    // Move pointer as necessary
+
+    return client;
+}
+
+/*
+ * Tile client at the end of the batch, unless it turns out to be
+ * transient for another window. Asks for WM_TRANSIENT_FOR now, so it's
+ * on its way with the rest of the batch's requests.
+ */
+void want_tile(struct client_win* client) {
+    struct props* props = props_get(&properties, client->id);
+
+    if(props != NULL) {
+        props_want(props, dpy, &replies, PROP_BIT(PROP_WM_TRANSIENT_FOR));
+    }
+    if(props == NULL || !stack_push(&pending_tiles, client->id)) {
+        tile_window(client);
+    }
+}
+
+/*
+ * Tile the windows want_tile() was asked to. Dialogs float over what
+ * they belong to instead, so this waits for the WM_TRANSIENT_FOR
+ * replies still out: one round trip, and only in batches with new
+ * windows.
+ */
+void tile_pending(void) {
+    bool waiting = false;
+
+    if(pending_tiles.len == 0) {
+        return;
+    }
+    for(uint32_t i = 0; i < pending_tiles.len; i++) {
+        struct props* props = props_find(&properties, pending_tiles.ids[i]);
+
+        if(props != NULL && !props_have(props, PROP_BIT(PROP_WM_TRANSIENT_FOR))) {
+            waiting = true;
+        }
+    }
+    if(waiting) {
+        stats_flush(dpy);
+        async_resolve(&replies, dpy);
+    }
+
+    for(uint32_t i = 0; i < pending_tiles.len; i++) {
+        struct client_win* client = find_client(pending_tiles.ids[i]);
+        struct props* props = props_find(&properties, pending_tiles.ids[i]);
+
+        if(client == NULL || client->layout != NULL) {
+            continue;
+        }
+        // Without an answer it's taken for a normal window
+        if(props == NULL || !props_have(props, PROP_BIT(PROP_WM_TRANSIENT_FOR))
+                || props->transient_for == XCB_NONE) {
+            tile_window(client);
+        }
+    }
+    stack_clear(&pending_tiles);
+}
+
+/*
+ * Map the windows that asked to be, now that the batch has put them
+ * where they go. Those on hidden workspaces wait until theirs is shown.
+ */
+void map_pending(void) {
+    for(uint32_t i = 0; i < pending_maps.len; i++) {
+        struct client_win* client = find_client(pending_maps.ids[i]);
+
+        if(client != NULL && client->workspace == workspace) {
+            map_client(client);
+        } else if(client != NULL) {
+            set_wm_state(client->id, WM_STATE_ICONIC);
+        }
+    }
+    stack_clear(&pending_maps);
+}
+
+/*
+ * Manage every window that's already mapped. Asks about all of them in
+ * one go instead of one round trip per window.
+ */
+void adopt_windows(bool hidden_too) {
+    xcb_query_tree_reply_t* tree;
+    xcb_window_t* children;
+    xcb_get_window_attributes_cookie_t* attr_cookies;
+    xcb_get_geometry_cookie_t* geom_cookies;
+    xcb_get_property_cookie_t* state_cookies = NULL;
+    int n;
+
+    tree = stats_reply(xcb_query_tree_reply(dpy, xcb_query_tree(dpy, screen->root), NULL));
+    stats.roundtrips++;
+    if(tree == NULL) {
+        PDEBUG("Couldn't query existing windows!");
+        return;
+    }
+    children = xcb_query_tree_children(tree);
+    n = xcb_query_tree_children_length(tree);
+
+    attr_cookies = malloc(n * sizeof(xcb_get_window_attributes_cookie_t));
+    geom_cookies = malloc(n * sizeof(xcb_get_geometry_cookie_t));
+    if(hidden_too) {
+        state_cookies = malloc(n * sizeof(xcb_get_property_cookie_t));
+    }
+    if(attr_cookies == NULL || geom_cookies == NULL || (hidden_too && state_cookies == NULL)) {
+        PDEBUG("Out of memory!");
+        free(attr_cookies);
+        free(geom_cookies);
+        free(state_cookies);
+        stats_reply_free(tree);
+        return;
+    }
+
+    for(int i = 0; i < n; i++) {
+        attr_cookies[i] = xcb_get_window_attributes(dpy, children[i]);
+        geom_cookies[i] = xcb_get_geometry(dpy, children[i]);
+        // Withdrawn windows are set WithdrawnState, the ones we hid
+        // IconicState, and ones never mapped have none
+        if(hidden_too) {
+            state_cookies[i] = xcb_get_property(dpy, 0, children[i], atoms[ATOM_WM_STATE],
+                                                atoms[ATOM_WM_STATE], 0, 1);
+        }
+        // QueryTree lists them bottom to top
+        stack_push(&stack, children[i]);
+    }
+
+    // Size the client table once instead of growing it as we go
+    wintable_reserve(&clients, clients.count + n);
+    stats.roundtrips++;
+
+    for(int i = 0; i < n; i++) {
+        xcb_get_window_attributes_reply_t* attr;
+        xcb_get_geometry_reply_t* geom;
+        xcb_get_property_reply_t* state = NULL;
+        bool hidden = false;
+
+        attr = stats_reply(xcb_get_window_attributes_reply(dpy, attr_cookies[i], NULL));
+        geom = stats_reply(xcb_get_geometry_reply(dpy, geom_cookies[i], NULL));
+        if(hidden_too) {
+            state = stats_reply(xcb_get_property_reply(dpy, state_cookies[i], NULL));
+            hidden = state != NULL && xcb_get_property_value_length(state) >= 4
+                     && *(uint32_t*) xcb_get_property_value(state) == WM_STATE_ICONIC;
+        }
+        // Gone already, not ours to manage, or not on screen. Unless
+        // we had it before a restart, on another workspace.
+        if(attr != NULL && geom != NULL
+                && !attr->override_redirect
+                && (attr->map_state == XCB_MAP_STATE_VIEWABLE || snapshot_find(&snapshot, children[i]) || hidden)
+                && !find_client(children[i])) {
+            struct client_win* client = setup_window(children[i], geom);
+            const struct snapshot_client* rec = snapshot_find(&snapshot, children[i]);
+
+            if(client != NULL) {
+                list_client(client);
+            }
+            if(client != NULL && attr->map_state == XCB_MAP_STATE_VIEWABLE) {
+                set_viewable(client, true);
+                set_wm_state(client->id, WM_STATE_NORMAL);
+            }
+            if(client != NULL && rec != NULL) {
+                restore_window(client, rec);
+            } else if(client != NULL) {
+                want_tile(client);
+                // Which workspace it was on is lost; this one, then
+                if(attr->map_state != XCB_MAP_STATE_VIEWABLE) {
+                    stack_push(&pending_maps, client->id);
+                }
+            }
+        }
+        stats_reply_free(attr);
+        stats_reply_free(geom);
+        stats_reply_free(state);
+    }
+    PDEBUG("Adopted %u of %d existing windows", clients.count, n);
+
+    free(attr_cookies);
+    free(geom_cookies);
+    free(state_cookies);
+    stats_reply_free(tree);
+}
+
+/*
+ * We can't carry on from the snapshot in fd, if any: map every window
+ * in it, so nothing the old qtwm hid on another workspace stays hidden
+ * for good. Whoever manages the screen gets them as MapRequests.
+ */
+void unhide_snapshot(int fd) {
+    if(fd < 0 || !snapshot_read(&snapshot, fd)) {
+        return;
+    }
+    for(uint32_t i = 0; i < snapshot.header.count; i++) {
+        xcb_map_window(dpy, snapshot.clients[i].window);
+    }
+    snapshot_free(&snapshot);
+    xcb_flush(dpy);
+}
+
+/*
+ * Give client back what we knew about it before the restart. Tiling
+ * waits for restore_order().
+ */
+void restore_window(struct client_win* client, const struct snapshot_client* rec) {
+    client->workspace = rec->workspace < WORKSPACES ? rec->workspace : workspace;
+    client->sync_value = rec->sync_value;
+}
+
+/*
+ * Put the restored windows back in the order they were in before the
+ * restart: the client list, the layouts and the focus order.
+ */
+void restore_order(void) {
+    uint32_t n = snapshot.header.count;
+    struct client_win** mru;
+    struct client_win* focus = NULL;
+
+    if(n == 0) {
+        return;
+    }
+    mru = calloc(n, sizeof(struct client_win*));
+
+    for(uint32_t i = 0; i < n; i++) {
+        const struct snapshot_client* rec = &snapshot.clients[i];
+        struct client_win* client = find_client(rec->window);
+
+        if(client == NULL) {
+            continue;
+        }
+        // Oldest first, like it was
+        clientlist_remove(&client_list, client->id);
+        clientlist_append(&client_list, client->id);
+        // The layouts come out the same if they're filled the same way
+        if(rec->tiled) {
+            tile_window(client);
+        }
+        if(mru != NULL && rec->mru < n) {
+            mru[rec->mru] = client;
+        }
+    }
+
+    // Least recent first, so the most recent ends up at the head
+    for(uint32_t i = n; mru != NULL && i > 0; i--) {
+        if(mru[i - 1] != NULL) {
+            movetohead(&winlist, &mru[i - 1]->window_item);
+            focus = mru[i - 1];
+        }
+    }
+    free(mru);
+
+    if(focus != NULL && focus->workspace == workspace) {
+        xcb_set_input_focus(dpy, XCB_INPUT_FOCUS_POINTER_ROOT, focus->id, XCB_CURRENT_TIME);
+        set_border_color(focus->id, true);
+        hover = hover_shown = focus->id;
+    }
+}
+
+/*
+ * Exec a fresh qtwm with the arguments we got, handing it a snapshot
+ * of what we know so it can carry on where we leave off. Only returns
+ * if that fails, with everything as it was.
+ */
+void restart(char** argv) {
+    struct snapshot_client* recs = calloc(client_list.len, sizeof(struct snapshot_client));
+    uint32_t* rank = calloc(store.len, sizeof(uint32_t));
+    char** args;
+    uint32_t n = 0;
+    uint32_t r = 0;
+    int argc = 0;
+    int k = 0;
+    char fd_arg[16];
+    int fd;
+
+    while(argv[argc] != NULL) {
+        argc++;
+    }
+    args = calloc(argc + 3, sizeof(char*));
+    if(recs == NULL || rank == NULL || args == NULL) {
+        fprintf(stderr, "qtwm: can't restart: out of memory\n");
+        free(recs);
+        free(rank);
+        free(args);
+        return;
+    }
+
+    for(struct item* item = winlist; item != NULL; item = item->next) {
+        int32_t i = client_index(((struct client_win*) item->data)->id);
+
+        if(i >= 0) {
+            rank[i] = r++;
+        }
+    }
+    for(uint32_t j = 0; j < client_list.len; j++) {
+        struct client_win* client = find_client(client_list.ids[j]);
+        int32_t i = client_index(client_list.ids[j]);
+
+        if(client == NULL || i < 0) {
+            continue;
+        }
+        recs[n].window = client->id;
+        recs[n].workspace = client->workspace;
+        recs[n].mru = rank[i];
+        recs[n].tiled = client->layout != NULL;
+        recs[n].sync_value = client->sync_value;
+        n++;
+    }
+    fd = snapshot_write(workspace, recs, n);
+    free(recs);
+    free(rank);
+    if(fd < 0) {
+        perror("qtwm: can't restart: writing the snapshot");
+        free(args);
+        return;
+    }
+
+    // Ours, with the snapshot up front; one we were handed is gone
+    snprintf(fd_arg, sizeof(fd_arg), "%d", fd);
+    args[k++] = argv[0];
+    args[k++] = "-s";
+    args[k++] = fd_arg;
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "--") == 0) {
+            while(i < argc) {
+                args[k++] = argv[i++];
+            }
+        } else if(strcmp(argv[i], "-s") == 0) {
+            i++;
+        } else if(strncmp(argv[i], "-s", 2) != 0) {
+            // Trace paths are taken as they are
+            if((strcmp(argv[i], "-t") == 0 || strcmp(argv[i], "-r") == 0) && i + 1 < argc) {
+                args[k++] = argv[i++];
+            }
+            args[k++] = argv[i];
+        }
+    }
+    args[k] = NULL;
+
+    // Windows on other workspaces are unmapped, and the server maps
+    // everything in our save set when we disconnect
+    for(struct item* item = winlist; item != NULL; item = item->next) {
+        struct client_win* client = item->data;
+
+        if(client->workspace != workspace) {
+            xcb_change_save_set(dpy, XCB_SET_MODE_DELETE, client->id);
+        }
+    }
+    ipc_close(&ipc);
+    // The connection closes when exec works out, and not before: if it
+    // doesn't, we're still around to undo that
+    xcb_flush(dpy);
+    fcntl(xcb_get_file_descriptor(dpy), F_SETFD, FD_CLOEXEC);
+
+    if(recording.file) {
+        fflush(recording.file);
+    }
+    execvp(argv[0], args);
+    perror("qtwm: can't restart");
+    free(args);
+    close(fd);
+
+    // Have the server map them as we go after all
+    for(struct item* item = winlist; item != NULL; item = item->next) {
+        struct client_win* client = item->data;
+
+        if(client->workspace != workspace) {
+            xcb_change_save_set(dpy, XCB_SET_MODE_INSERT, client->id);
+        }
+    }
+    listen_ipc();
+}
+
+/*
+ * Start managing window. If geom is NULL its geometry is fetched in the
+ * background.
+ */
+struct client_win* setup_window(xcb_window_t window, const xcb_get_geometry_reply_t* geom) {
+    uint32_t values[2];
+    uint32_t mask = 0;
+    struct client_win* client;
+    xcb_get_geometry_cookie_t cookie;
+
+    // Set border color
+    set_border_color(window, false);
+    set_border_width(window);
+
+    mask = XCB_CW_EVENT_MASK;
+    values[0] = XCB_EVENT_MASK_ENTER_WINDOW
+                | XCB_EVENT_MASK_FOCUS_CHANGE
+                | XCB_EVENT_MASK_LEAVE_WINDOW
+                | XCB_EVENT_MASK_PROPERTY_CHANGE;
+    xcb_change_window_attributes(dpy, window, mask, values);
+
+    // Add this window to the X Save Set
+    xcb_change_save_set(dpy, XCB_SET_MODE_INSERT, window);
+
+    // Remember window and store a few things about it
+
+    client = pool_alloc(&client_pool);
+    if(client == NULL) {
+        PDEBUG("Out of memory!");
+        return NULL;
+    }
+    stats_alloc(STATS_MEM_CLIENTS);
+
+    if(geom != NULL) {
+        client->handle = store_add(&store, window, geom->x, geom->y, geom->width, geom->height);
+    } else {
+        client->handle = store_add(&store, window, 0, 0, 0, 0);
+    }
+    if(client->handle == STORE_NONE) {
+        PDEBUG("Out of memory!");
+        pool_free(&client_pool, client);
+        stats_free(STATS_MEM_CLIENTS);
+        return NULL;
+    }
+
+    // set_border_width() above is on its way
+    store_set_border(&store, store_index(&store, client->handle), BORDER_WIDTH);
+
+    if(!wintable_put(&clients, window, client)) {
+        PDEBUG("Out of memory!");
+        store_remove(&store, client->handle);
+        pool_free(&client_pool, client);
+        stats_free(STATS_MEM_CLIENTS);
+        return NULL;
+    }
+
+    // Initialize client
+    client->id = window;
+    client->layout = NULL;
+    client->workspace = workspace;
+    client->unmaps_len = 0;
+    client->sync_counter = XCB_NONE;
+    client->sync_value = 0;
+    client->window_item.data = client;
+    linkitem(&winlist, &client->window_item);
+
+    if(geom == NULL) {
+        // Get geometry, store in client once it's here
+        cookie = xcb_get_geometry(dpy, window);
+        async_push(&replies, dpy, cookie.sequence, setup_window_geom, (void*) (uintptr_t) window);
+    }
+
+    // How do we talk to it? WM_STATE waits for it to be mapped.
+    get_protocols(window);
+
+    return client;
+}
+
+/*
+ * Where tiled windows may go on mon.
+ */
+xcb_rectangle_t tiling_area(const struct monitor* mon) {
+    xcb_rectangle_t area;
+
+    area.x = mon->x + LEFT_PADDING;
+    area.y = mon->y + TOP_PADDING;
+    area.width = mon->w > LEFT_PADDING + RIGHT_PADDING ? mon->w - LEFT_PADDING - RIGHT_PADDING : 1;
+    area.height = mon->h > TOP_PADDING + BOTTOM_PADDING ? mon->h - TOP_PADDING - BOTTOM_PADDING : 1;
+
+    return area;
+}
+
+/*
+ * Make the layouts match the monitors.
+ */
+void sync_layouts(void) {
+    struct layout* fresh;
+    struct layout* old = layouts;
+    uint32_t nold = layout_monitors * WORKSPACES;
+
+    if(TILING_LAYOUT == LAYOUT_FLOATING) {
+        return;
+    }
+
+    // Same monitors, maybe resized
+    if(layout_monitors == monitors.len) {
+        for(uint32_t i = 0; i < nold; i++) {
+            layout_set_area(&layouts[i], tiling_area(&monitors.mons[i % layout_monitors]));
+        }
+        return;
+    }
+
+    // Monitors came or went, which is rare enough to start over
+    fresh = calloc(monitors.len * WORKSPACES, sizeof(struct layout));
+    if(fresh == NULL) {
+        PDEBUG("Out of memory! Layouts stay as they are.");
+        return;
+    }
+    for(uint32_t i = 0; i < monitors.len * WORKSPACES; i++) {
+        layout_init(&fresh[i], TILING_LAYOUT, tiling_area(&monitors.mons[i % monitors.len]));
+    }
+    layouts = fresh;
+    layout_monitors = monitors.len;
+
+    for(struct item* item = winlist; item != NULL; item = item->next) {
+        struct client_win* client = item->data;
+
+        if(client->layout != NULL) {
+            client->layout = NULL;
+            tile_window(client);
+        }
+    }
+
+    for(uint32_t i = 0; i < nold; i++) {
+        layout_free(&old[i]);
+    }
+    free(old);
+}
+
+/*
+ * Tile client on its workspace, on the monitor it's on, or the one
+ * with the focus if we don't know yet.
+ */
+void tile_window(struct client_win* client) {
+    int32_t i = store_index(&store, client->handle);
+    int32_t m = -1;
+    struct layout* layout;
+
+    if(layout_monitors == 0 || i < 0) {
+        return;
+    }
+    if(store.w[i] > 0) {
+        m = monitor_for_rect(&monitors, store.x[i], store.y[i], store.w[i], store.h[i]);
+    } else if(winlist != NULL && winlist->data != client) {
+        int32_t f = client_index(((struct client_win*) winlist->data)->id);
+
+        if(f >= 0) {
+            m = monitor_for_rect(&monitors, store.x[f], store.y[f], store.w[f], store.h[f]);
+        }
+    }
+    if(m < 0 || (uint32_t) m >= layout_monitors) {
+        m = 0;
+    }
+
+    layout = &layouts[client->workspace * layout_monitors + m];
+    if(layout_insert(layout, client->id)) {
+        client->layout = layout;
+    }
+}
+
+void untile_window(struct client_win* client) {
+    if(client->layout != NULL) {
+        layout_remove(client->layout, client->id);
+        client->layout = NULL;
+    }
+}
+
+/*
+ * Layout callback: rect includes the border.
+ */
+void place_window(xcb_window_t window, xcb_rectangle_t rect) {
+    int32_t i = client_index(window);
+    uint16_t w = rect.width > 2 * BORDER_WIDTH ? rect.width - 2 * BORDER_WIDTH : 1;
+    uint16_t h = rect.height > 2 * BORDER_WIDTH ? rect.height - 2 * BORDER_WIDTH : 1;
+
+    // Already there
+    if(i >= 0 && store.x[i] == rect.x && store.y[i] == rect.y && store.w[i] == w && store.h[i] == h) {
+        return;
+    }
+    move_resize_window(window, rect.x, rect.y, w, h);
+}
+
+/*
+ * Place the tiled windows on screen. The other workspaces' layouts
+ * keep their changes until they're shown.
+ */
+void apply_layouts(void) {
+    for(uint32_t m = 0; m < layout_monitors; m++) {
+        layout_apply(&layouts[workspace * layout_monitors + m], place_window);
+    }
+}
+
+/*
+ * Show workspace n instead of the current one. Everything happens
+ * inside one server grab, and the caller flushes it all at once.
+ */
+void switch_workspace(uint32_t n) {
+    uint32_t old = workspace;
+
+    if(n >= WORKSPACES || n == old) {
+        return;
+    }
+    workspace = n;
+
+    xcb_grab_server(dpy);
+    // Tiled windows get where they belong while still unmapped
+    apply_layouts();
+    // Map the new windows before unmapping the old ones, so whatever
+    // is under both never gets exposed in between
+    for(struct item* item = winlist; item != NULL; item = item->next) {
+        struct client_win* client = item->data;
+
+        if(client->workspace == n) {
+            map_client(client);
+        }
+    }
+    for(struct item* item = winlist; item != NULL; item = item->next) {
+        struct client_win* client = item->data;
+
+        if(client->workspace == old) {
+            unmap_client(client);
+        }
+    }
+    xcb_ungrab_server(dpy);
+
+    xcb_change_property(dpy, XCB_PROP_MODE_REPLACE, screen->root, atoms[ATOM__NET_CURRENT_DESKTOP],
+                        XCB_ATOM_CARDINAL, 32, 1, &workspace);
+}
+
+/*
+ * Move client to workspace n.
+ */
+void send_to_workspace(struct client_win* client, uint32_t n) {
+    bool tiled = client->layout != NULL;
+
+    if(n >= WORKSPACES || n == client->workspace) {
+        return;
+    }
+    if(client->workspace == workspace) {
+        unmap_client(client);
+    } else if(n == workspace) {
+        map_client(client);
+    }
+    untile_window(client);
+    client->workspace = n;
+    if(tiled) {
+        tile_window(client);
+    }
+}
+
+/*
+ * Tell window where it is, since it isn't going where it asked.
+ */
+void deny_configure(xcb_window_t window) {
+    int32_t i = client_index(window);
+    xcb_configure_notify_event_t ev;
+
+    if(i < 0) {
+        return;
+    }
+    memset(&ev, 0, sizeof(ev));
+    ev.response_type = XCB_CONFIGURE_NOTIFY;
+    ev.event = window;
+    ev.window = window;
+    ev.above_sibling = XCB_NONE;
+    ev.x = store.x[i];
+    ev.y = store.y[i];
+    ev.width = store.w[i];
+    ev.height = store.h[i];
+    ev.border_width = store.border[i];
+    xcb_send_event(dpy, 0, window, XCB_EVENT_MASK_STRUCTURE_NOTIFY, (const char*) &ev);
+}
+
+/*
+ * Put window on top of everything, and its dialogs on top of it, as
+ * far as we know them. Nothing goes out for what's already there.
+ */
+void raise_window(xcb_window_t window) {
+    // Plenty for dialogs
+    xcb_window_t group[16];
+    uint32_t n = 1;
+    unsigned int first, last;
+
+    group[0] = window;
+    // winlist is in MRU order
+    for(struct item* item = winlist; item != NULL && n < 16; item = item->next) {
+        struct client_win* client = item->data;
+        struct props* props = props_find(&properties, client->id);
+
+        if(client->workspace == workspace && props != NULL && props_have(props, PROP_BIT(PROP_WM_TRANSIENT_FOR))
+                && props->transient_for == window && client->id != window) {
+            group[n++] = client->id;
+        }
+    }
+    // Gathered most recent first; the most recent goes on top
+    for(uint32_t i = 1, j = n - 1; i < j; i++, j--) {
+        xcb_window_t t = group[i];
+
+        group[i] = group[j];
+        group[j] = t;
+    }
+
+    if((last = stack_raise(&stack, dpy, group, n, &first)) == 0) {
+        return;
+    }
+    note_crossing(first);
+    note_crossing(last);
+    for(uint32_t i = 0; i < n; i++) {
+        stacking_changed(group[i]);
+    }
+}
+
+/*
+ * window moved in the stacking order; move it in the stacking list
+ * panels see too.
+ */
+void stacking_changed(xcb_window_t window) {
+    int64_t i = stack_index(&stack, window);
+
+    if(i < 0 || find_client(window) == NULL) {
+        return;
+    }
+    // The nearest managed window under it
+    while(--i >= 0 && find_client(stack.ids[i]) == NULL) {
+    }
+    clientlist_place(&stacking_list, window, i >= 0 ? stack.ids[i] : XCB_NONE);
+}
+
+/*
+ * client asked to be mapped: it goes in the client lists, as the newest
+ * and where it is in the stacking order. Until then panels have no
+ * business knowing it.
+ */
+void list_client(struct client_win* client) {
+    int32_t i = store_index(&store, client->handle);
+
+    if(i < 0 || (store.flags[i] & CLIENT_LISTED)) {
+        return;
+    }
+    if(!clientlist_append(&client_list, client->id)) {
+        PDEBUG("Out of memory! 0x%x is missing from the client lists.", client->id);
+        return;
+    }
+    if(!clientlist_append(&stacking_list, client->id)) {
+        PDEBUG("Out of memory! 0x%x is missing from the client lists.", client->id);
+        clientlist_remove(&client_list, client->id);
+        return;
+    }
+    store.flags[i] |= CLIENT_LISTED;
+    stacking_changed(client->id);
+}
+
+/*
+ * Topmost managed window on screen at root coordinates x/y, or
+ * XCB_NONE. Answered from our stacking order and geometry cache, so it
+ * costs no round trip; windows we don't manage or that aren't mapped
+ * don't count.
+ */
+xcb_window_t window_at(int16_t x, int16_t y) {
+    for(int64_t k = (int64_t) stack.len - 1; k >= 0; k--) {
+        struct client_win* client = find_client(stack.ids[k]);
+        int32_t i;
+
+        if(client == NULL || client->workspace != workspace
+                || (i = store_index(&store, client->handle)) < 0
+                || !(store.flags[i] & CLIENT_VIEWABLE)) {
+            continue;
+        }
+        if(x >= store.x[i] && x < store.x[i] + store.w[i] + 2 * store.border[i]
+                && y >= store.y[i] && y < store.y[i] + store.h[i] + 2 * store.border[i]) {
+            return client->id;
+        }
+    }
+
+    return XCB_NONE;
+}
+
+/*
+ * Raise window and give it the input focus.
+ */
+void focus_window(xcb_window_t window) {
+    struct client_win* client = find_client(window);
+
+    if(client == NULL) {
+        return;
+    }
+    if(hover_shown != XCB_NONE && hover_shown != window) {
+        set_border_color(hover_shown, false);
+    }
+    movetohead(&winlist, &client->window_item);
+    if(client->layout) {
+        layout_focus(client->layout, window);
+    }
+    raise_window(window);
+    xcb_set_input_focus(dpy, XCB_INPUT_FOCUS_POINTER_ROOT, window, XCB_CURRENT_TIME);
+    set_border_color(window, true);
+    hover = hover_shown = window;
+}
+
+/*
+ * Get rid of window's client.
+ */
+void close_window(xcb_window_t window) {
+    int32_t i = client_index(window);
+    xcb_client_message_event_t ev;
+
+    // Without WM_DELETE_WINDOW, all we can do is kill the connection
+    if(i < 0 || !(store.flags[i] & CLIENT_DELETE_WINDOW)) {
+        xcb_kill_client(dpy, window);
+        return;
+    }
+
+    memset(&ev, 0, sizeof(ev));
+    ev.response_type = XCB_CLIENT_MESSAGE;
+    ev.format = 32;
+    ev.window = window;
+    ev.type = atoms[ATOM_WM_PROTOCOLS];
+    ev.data.data32[0] = atoms[ATOM_WM_DELETE_WINDOW];
+    ev.data.data32[1] = XCB_CURRENT_TIME;
+    xcb_send_event(dpy, 0, window, XCB_EVENT_MASK_NO_EVENT, (const char*) &ev);
+}
+
+void set_border_color(xcb_window_t window, bool focus) {
+    uint32_t values[1];
+    values[0] = focus ? BORDER_COLOR_FOCUSED : BORDER_COLOR_UNFOCUSED;
+    xcb_change_window_attributes(dpy, window, XCB_CW_BORDER_PIXEL, values);
+}
+
+void set_border_width(xcb_window_t window) {
+    uint32_t values[1];
+    values[0] = BORDER_WIDTH;
+    note_crossing(xcb_configure_window(dpy, window, XCB_CONFIG_WINDOW_BORDER_WIDTH, values).sequence);
+}
+
+void forgetwindow(xcb_window_t window) {
+    struct client_win* client;
+
+    client = wintable_del(&clients, window);
+    if(client == NULL) {
+        return;
+    }
+    PDEBUG("Found client. Forgetting...");
+
+    if(hover == window) {
+        hover = XCB_NONE;
+    }
+    if(hover_shown == window) {
+        hover_shown = XCB_NONE;
+    }
+    untile_window(client);
+    unlinkitem(&winlist, &client->window_item);
+    clientlist_remove(&client_list, window);
+    clientlist_remove(&stacking_list, window);
+    props_forget(&properties, window);
+    stack_remove(&pending_maps, window);
+    stack_remove(&pending_tiles, window);
+    store_remove(&store, client->handle);
+    pool_free(&client_pool, client);
+    stats_free(STATS_MEM_CLIENTS);
+}
+
+void setup_window_geom(void* data, void* reply) {
+    xcb_get_geometry_reply_t* geom = reply;
+    struct client_win* client;
+
+    if(geom == NULL) {
+        PDEBUG("Couldn't get geometry for initial window setup!");
+        return;
+    }
+    // The window may be gone by now
+    client = find_client((xcb_window_t) (uintptr_t) data);
+    if(client == NULL) {
+        return;
+    }
+    PDEBUG("Got geometry: %dx%d+%dx%d", geom->x, geom->y, geom->width, geom->height)
+
+    store_set_geom(&store, store_index(&store, client->handle),
+                   geom->x, geom->y, geom->width, geom->height);
+    store_set_border(&store, store_index(&store, client->handle), geom->border_width);
+}
+
+/*
+ * Find out which WM_PROTOCOLS window speaks, and its sync counter, in
+ * the background.
+ */
+void get_protocols(xcb_window_t window) {
+    xcb_get_property_cookie_t cookie;
+
+    cookie = xcb_get_property(dpy, 0, window, atoms[ATOM_WM_PROTOCOLS], XCB_ATOM_ATOM, 0, 32);
+    async_push(&replies, dpy, cookie.sequence, protocols_reply, (void*) (uintptr_t) window);
+    cookie = xcb_get_property(dpy, 0, window, atoms[ATOM__NET_WM_SYNC_REQUEST_COUNTER],
+                              XCB_ATOM_CARDINAL, 0, 2);
+    async_push(&replies, dpy, cookie.sequence, sync_counter_reply, (void*) (uintptr_t) window);
+}
+
+void protocols_reply(void* data, void* reply) {
+    xcb_get_property_reply_t* prop = reply;
+    int32_t i = client_index((xcb_window_t) (uintptr_t) data);
+    xcb_atom_t* protocols;
+    int n;
+
+    if(i < 0) {
+        return;
+    }
+    store.flags[i] &= ~(CLIENT_DELETE_WINDOW | CLIENT_SYNC_REQUEST);
+    if(prop == NULL || prop->type != XCB_ATOM_ATOM || prop->format != 32) {
+        return;
+    }
+
+    protocols = xcb_get_property_value(prop);
+    n = xcb_get_property_value_length(prop) / 4;
+    for(int j = 0; j < n; j++) {
+        if(protocols[j] == atoms[ATOM_WM_DELETE_WINDOW]) {
+            store.flags[i] |= CLIENT_DELETE_WINDOW;
+        } else if(protocols[j] == atoms[ATOM__NET_WM_SYNC_REQUEST]) {
+            store.flags[i] |= CLIENT_SYNC_REQUEST;
+        }
+    }
+}
+
+void sync_counter_reply(void* data, void* reply) {
+    xcb_get_property_reply_t* prop = reply;
+    struct client_win* client = find_client((xcb_window_t) (uintptr_t) data);
+
+    if(client == NULL) {
+        return;
+    }
+    client->sync_counter = XCB_NONE;
+    // The first counter is the basic one, which is all we use
+    if(prop == NULL || prop->type != XCB_ATOM_CARDINAL || prop->format != 32
+            || xcb_get_property_value_length(prop) < 4) {
+        return;
+    }
+    client->sync_counter = *(uint32_t*) xcb_get_property_value(prop);
+}
+
+void button_press_geom(void* data, void* reply) {
+    xcb_get_geometry_reply_t* geom = reply;
+    xcb_window_t window = press.window;
+
+    // Button already released, or the window is gone
+    if(window == XCB_NONE || geom == NULL) {
+        return;
+    }
+    press.window = XCB_NONE;
+    start_drag(window, press.mode, geom->x, geom->y, geom->width, geom->height, geom->border_width);
+}
+
+/*
+ * Start dragging window, which is at x/y/w/h with a border this wide.
+ */
+void start_drag(xcb_window_t window, enum drag_mode mode,
+                int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t border) {
+    int16_t anchor_x, anchor_y;
+
+    // Move mouse pointer as needed. Warp coordinates are relative
+    // to the inside of the border, drag coordinates to the root.
+    anchor_x = x + border;
+    anchor_y = y + border;
+    if(mode == DRAG_MOVE) {
+        xcb_warp_pointer(dpy, XCB_NONE, window, 0, 0, 0, 0, 1, 1);
+        drag_begin(&drag, DRAG_MOVE, window, anchor_x + 1, anchor_y + 1, x, y, w, h);
+    } else {
+        struct client_win* client = find_client(window);
+        int32_t i = client_index(window);
+        struct props* props;
+
+        xcb_warp_pointer(dpy, XCB_NONE, window, 0, 0, 0, 0, w, h);
+        drag_begin(&drag, DRAG_RESIZE, window, anchor_x + w, anchor_y + h, x, y, w, h);
+        // Here by the first motion, unless it's in this very batch
+        if(client != NULL && (props = props_get(&properties, window)) != NULL) {
+            props_want(props, dpy, &replies, PROP_BIT(PROP_WM_NORMAL_HINTS));
+        }
+        // Without this, resizes go out on the timer
+        if(i >= 0 && (store.flags[i] & CLIENT_SYNC_REQUEST)) {
+            xsync_watch(&xsync, dpy, client->sync_counter);
+        }
+    }
+}
+
+/*
+ * Send the drag's newest geometry. A resize waits for the client to
+ * catch up with the one before: until its sync counter says so, or
+ * for clients without one, until the resize timer goes off. The timer
+ * also gives up on sync clients that never answer.
+ */
+void apply_drag(void) {
+    xcb_rectangle_t geom;
+    uint32_t values[2];
+    struct client_win* client;
+    int32_t i;
+
+    if(!drag_next(&drag, &geom)) {
+        return;
+    }
+
+    if(drag.mode == DRAG_MOVE) {
+        values[0] = (uint32_t) geom.x;
+        values[1] = (uint32_t) geom.y;
+        note_crossing(xcb_configure_window(dpy, drag.window, XCB_MOVE, values).sequence);
+    } else {
+        client = find_client(drag.window);
+        if(client != NULL && xsync.alarm != XCB_NONE) {
+            // Has to reach the client before the ConfigureNotify does
+            xsync_request(&xsync, dpy, drag.window, ++client->sync_value);
+            loop_timer_arm(&resize_timer, SYNC_TIMEOUT_MS * 1000000ull, 0);
+        } else {
+            loop_timer_arm(&resize_timer, RESIZE_INTERVAL_MS * 1000000ull, 0);
+        }
+        apply_size_hints(drag.window, &geom.width, &geom.height);
+        values[0] = geom.width;
+        values[1] = geom.height;
+        note_crossing(xcb_configure_window(dpy, drag.window, XCB_RESIZE, values).sequence);
+        // Replaying a trace, nothing would ever let the next one go
+        if(!loop.running) {
+            drag_ready(&drag);
+        }
+    }
+
+    if((i = client_index(drag.window)) >= 0) {
+        store_set_geom(&store, i, geom.x, geom.y, geom.width, geom.height);
+    }
+}
+
+/*
+ * Request sequence may move windows under the pointer; the crossing
+ * events it causes aren't the user's doing.
+ */
+void note_crossing(unsigned int sequence) {
+    if(sequence == 0) {
+        return;
+    }
+    if(ours.from == 0) {
+        ours.from = sequence;
+    }
+    ours.to = sequence;
+    ours.fenced = false;
+}
+
+/*
+ * Crossings carry the sequence number of the last request the server
+ * handled. If that stays one of ours because nothing goes out after
+ * it, the user's own crossings look like ours until something does.
+ * Make sure something does; called before flushing.
+ */
+void fence_crossings(void) {
+    if(ours.from != 0 && !ours.fenced) {
+        xcb_no_operation(dpy);
+        ours.fenced = true;
+    }
+}
+
+/*
+ * Was the crossing event with sequence caused by a request of ours? It
+ * carries the sequence number of the request that caused it.
+ */
+bool our_crossing(uint32_t sequence) {
+    if(replaying) {
+        return replayed_ours;
+    }
+    return ours.from != 0 && (int32_t) (sequence - ours.from) >= 0 && (int32_t) (sequence - ours.to) <= 0;
+}
+
+/*
+ * Set window's ICCCM WM_STATE: NormalState while we show it, IconicState
+ * while it's on a hidden workspace, WithdrawnState once it's not ours.
+ */
+void set_wm_state(xcb_window_t window, uint32_t state) {
+    uint32_t values[2] = { state, XCB_NONE };
+
+    xcb_change_property(dpy, XCB_PROP_MODE_REPLACE, window, atoms[ATOM_WM_STATE],
+                        atoms[ATOM_WM_STATE], 32, 2, values);
+}
+
+/*
+ * Note whether client is on screen, for window_at(). Our own maps and
+ * unmaps count from when they're sent.
+ */
+void set_viewable(struct client_win* client, bool viewable) {
+    int32_t i = store_index(&store, client->handle);
+
+    if(i < 0) {
+        return;
+    }
+    if(viewable) {
+        store.flags[i] |= CLIENT_VIEWABLE;
+    } else {
+        store.flags[i] &= ~CLIENT_VIEWABLE;
+    }
+}
+
+/*
+ * Show client.
+ */
+void map_client(struct client_win* client) {
+    note_crossing(xcb_map_window(dpy, client->id).sequence);
+    set_viewable(client, true);
+    set_wm_state(client->id, WM_STATE_NORMAL);
+}
+
+/*
+ * Hide client, remembering it was us and not the client withdrawing
+ * it.
+ */
+void unmap_client(struct client_win* client) {
+    unsigned int sequence = xcb_unmap_window(dpy, client->id).sequence;
+
+    note_crossing(sequence);
+    set_viewable(client, false);
+    set_wm_state(client->id, WM_STATE_ICONIC);
+    // Way more than can be on their way at once; the oldest is surely
+    // done with
+    if(client->unmaps_len == CLIENT_UNMAPS) {
+        memmove(client->unmaps, client->unmaps + 1, (CLIENT_UNMAPS - 1) * sizeof(unsigned int));
+        client->unmaps_len--;
+    }
+    client->unmaps[client->unmaps_len++] = sequence;
+}
+
+/*
+ * Was the UnmapNotify ev for client caused by unmap_client()? It
+ * carries the sequence number of the request that caused it. A count
+ * wouldn't do: if the client withdraws the window just before we unmap
+ * it, ours does nothing and sends no event, and the client's would be
+ * taken for it. Synthetic ones are clients withdrawing windows that
+ * were already unmapped, as ICCCM has it.
+ */
+bool our_unmap(struct client_win* client, xcb_generic_event_t* ev) {
+    uint8_t done = 0;
+    bool ours = false;
+
+    if(ev->response_type & 0x80) {
+        return false;
+    }
+    if(replaying) {
+        return replayed_ours;
+    }
+    // Events come in request order, so ours from before this one have
+    // either had their event or never will
+    while(done < client->unmaps_len && (int32_t) (client->unmaps[done] - ev->full_sequence) <= 0) {
+        ours = client->unmaps[done] == ev->full_sequence;
+        done++;
+    }
+    client->unmaps_len -= done;
+    memmove(client->unmaps, client->unmaps + done, client->unmaps_len * sizeof(unsigned int));
+
+    return ours;
+}
+
+/*
+ * Would ev be taken for the doing of our own requests? Only works
+ * before ev is handled, which may forget what tells.
+ */
+bool caused_by_us(const xcb_generic_event_t* ev) {
+    uint8_t type = ev->response_type & ~0x80;
+    struct client_win* client;
+
+    if(type == XCB_ENTER_NOTIFY || type == XCB_LEAVE_NOTIFY) {
+        return our_crossing(ev->full_sequence);
+    }
+    if(type != XCB_UNMAP_NOTIFY || (ev->response_type & 0x80)
+            || (client = find_client(((const xcb_unmap_notify_event_t*) ev)->window)) == NULL) {
+        return false;
+    }
+    for(uint8_t i = 0; i < client->unmaps_len; i++) {
+        if(client->unmaps[i] == ev->full_sequence) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*
+ * Show which window has the pointer, if that changed over the batch.
+ * However many crossing events it took to get there, that's two border
+ * changes at most.
+ */
+void apply_hover(void) {
+    struct client_win* client;
+
+    if(hover_stale) {
+        hover = window_at(pointer_x, pointer_y);
+        hover_stale = false;
+    }
+    if(hover == hover_shown) {
+        return;
+    }
+    if(hover_shown != XCB_NONE) {
+        set_border_color(hover_shown, false);
+    }
+    hover_shown = hover;
+    if((client = find_client(hover)) != NULL) {
+        // Keep winlist in MRU order for focus cycling
+        movetohead(&winlist, &client->window_item);
+        if(client->layout) {
+            layout_focus(client->layout, client->id);
+        }
+        set_border_color(hover, true);
+    }
+}
+
+/*
+ * Keep w/h within window's WM_NORMAL_HINTS, if we have them.
+ */
+void apply_size_hints(xcb_window_t window, uint16_t* w, uint16_t* h) {
+    struct props* props = props_find(&properties, window);
+    const struct prop_size_hints* hints;
+    int32_t base_w = 0, base_h = 0;
+
+    if(props == NULL || !props_have(props, PROP_BIT(PROP_WM_NORMAL_HINTS))) {
+        return;
+    }
+    hints = &props->normal_hints;
+
+    if(hints->flags & PROP_SIZE_HINT_MIN_SIZE) {
+        *w = *w < hints->min_width ? hints->min_width : *w;
+        *h = *h < hints->min_height ? hints->min_height : *h;
+        base_w = hints->min_width;
+        base_h = hints->min_height;
+    }
+    if(hints->flags & PROP_SIZE_HINT_BASE_SIZE) {
+        base_w = hints->base_width;
+        base_h = hints->base_height;
+    }
+    // Terminals want whole cells
+    if(hints->flags & PROP_SIZE_HINT_RESIZE_INC) {
+        if(hints->width_inc > 1 && *w > base_w) {
+            *w -= (*w - base_w) % hints->width_inc;
+        }
+        if(hints->height_inc > 1 && *h > base_h) {
+            *h -= (*h - base_h) % hints->height_inc;
+        }
+    }
+    if(hints->flags & PROP_SIZE_HINT_MAX_SIZE) {
+        *w = hints->max_width > 0 && *w > hints->max_width ? hints->max_width : *w;
+        *h = hints->max_height > 0 && *h > hints->max_height ? hints->max_height : *h;
+    }
+}
+
+void resize_timer_ready(struct loop_source* source, uint32_t events) {
+    if(loop_timer_read(source) == 0) {
+        return;
+    }
+    // Time for the next size, or the client isn't going to answer
+    drag_ready(&drag);
+    apply_drag();
+    stats_flush(dpy);
+}
+
+/*
+ * The alarm went off: the window being resized has its counter at
+ * value.
+ */
+void resize_handled(uint64_t value) {
+    struct client_win* client = find_client(drag.window);
+
+    if(client == NULL || value < client->sync_value) {
+        return;
+    }
+    // Ahead of us if a previous WM used the counter; carry on from there
+    client->sync_value = value;
+    drag_ready(&drag);
+    loop_timer_arm(&resize_timer, 0, 0);
+}
+
+void move_window(xcb_drawable_t window, int16_t x, int16_t y) {
+    uint32_t values[2] = { x, y };
+    int32_t i;
+    PDEBUG("Moving window to (%d %d)", x, y);
+    note_crossing(xcb_configure_window(dpy, window, XCB_MOVE, values).sequence);
+    if((i = client_index(window)) >= 0) {
+        store_set_geom(&store, i, x, y, store.w[i], store.h[i]);
+    }
+}
+
+void resize_window(xcb_drawable_t window, uint16_t w, uint16_t h) {
+    uint32_t values[2] = { w, h };
+    int32_t i;
+    PDEBUG("Resizing window to (%d, %d)!", w, h);
+    note_crossing(xcb_configure_window(dpy, window, XCB_RESIZE, values).sequence);
+    if((i = client_index(window)) >= 0) {
+        store_set_geom(&store, i, store.x[i], store.y[i], w, h);
+    }
+}
+
+void move_resize_window(xcb_drawable_t window, int16_t x, int16_t y, uint16_t w, uint16_t h) {
+    uint32_t values[4] = { x, y, w, h };
+    int32_t i;
+    PDEBUG("Changing geometry to %dx%d+%dx%d!", x, y, w, h);
+    note_crossing(xcb_configure_window(dpy, window, XCB_MOVE_RESIZE, values).sequence);
+    if((i = client_index(window)) >= 0) {
+        store_set_geom(&store, i, x, y, w, h);
+    }
+}
+
+void configure_request(xcb_configure_request_event_t* e) {
+    // Nothing is sent until the batch is over, so a client resizing in
+    // a loop gets one ConfigureWindow for all of it
+    struct configure conf;
+
+    if(configure_queue_add(&configures, e) != NULL) {
+        return;
+    }
+
+    PDEBUG("Out of memory! Configuring window right away.");
+    conf.window = e->window;
+    conf.mask = e->value_mask;
+    conf.x = e->x;
+    conf.y = e->y;
+    conf.w = e->width;
+    conf.h = e->height;
+    conf.border = e->border_width;
+    conf.sibling = e->sibling;
+    conf.stack_mode = e->stack_mode;
+    note_crossing(configure_send(dpy, &conf));
+}
+
+/*
+ * Grant every ConfigureRequest of this batch, each window's merged into
+ * one request. Managed or not, the client is waiting for an answer.
+ */
+void flush_configures(void) {
+    for(uint32_t i = 0; i < configures.len; i++) {
+        struct configure* conf = &configures.reqs[i];
+        struct client_win* client = find_client(conf->window);
+        int32_t j;
+
+        // The layout decides where tiled windows go. ICCCM says to
+        // tell the client so when we don't do what it asked.
+        if(client != NULL && client->layout != NULL) {
+            conf->mask &= ~(XCB_MOVE_RESIZE | XCB_CONFIG_WINDOW_BORDER_WIDTH);
+            deny_configure(conf->window);
+        }
+        note_crossing(configure_send(dpy, conf));
+
+        // TopIf, BottomIf and Opposite depend on what overlaps what;
+        // the ConfigureNotify will tell
+        if((conf->mask & XCB_CONFIG_WINDOW_STACK_MODE)
+                && (conf->stack_mode == XCB_STACK_MODE_ABOVE || conf->stack_mode == XCB_STACK_MODE_BELOW)
+                && stack_place(&stack, conf->window,
+                               conf->mask & XCB_CONFIG_WINDOW_SIBLING ? conf->sibling : XCB_NONE,
+                               conf->stack_mode)) {
+            stacking_changed(conf->window);
+        }
+
+        // Keep our idea of managed windows' geometry in step
+        if(client != NULL && (j = store_index(&store, client->handle)) >= 0) {
+            store_set_geom(&store, j,
+                           conf->mask & XCB_CONFIG_WINDOW_X ? conf->x : store.x[j],
+                           conf->mask & XCB_CONFIG_WINDOW_Y ? conf->y : store.y[j],
+                           conf->mask & XCB_CONFIG_WINDOW_WIDTH ? conf->w : store.w[j],
+                           conf->mask & XCB_CONFIG_WINDOW_HEIGHT ? conf->h : store.h[j]);
+            if(conf->mask & XCB_CONFIG_WINDOW_BORDER_WIDTH) {
+                store_set_border(&store, j, conf->border);
+            }
+        }
+    }
+    configure_queue_clear(&configures);
+}
+
+struct client_win* find_client(xcb_drawable_t window) {
+    return wintable_get(&clients, window);
+}
+
+/*
+ * Index of window in the store, or -1 if we don't manage it.
+ */
+int32_t client_index(xcb_window_t window) {
+    struct client_win* client = find_client(window);
+
+    return client ? store_index(&store, client->handle) : -1;
+}
+
+#ifdef DEBUG
+/*
+ * Ask the server where every managed window is, to catch the geometry
+ * cache drifting. Every request that changes a managed window's
+ * geometry went out before these, so the replies must match.
+ */
+void check_geometry(void) {
+    for(uint32_t i = 0; i < store.len; i++) {
+        xcb_get_geometry_cookie_t cookie = xcb_get_geometry(dpy, store.ids[i]);
+
+        async_push(&replies, dpy, cookie.sequence, check_geometry_reply,
+                   (void*) (uintptr_t) store.ids[i]);
+    }
+}
+
+void check_timer_ready(struct loop_source* source, uint32_t events) {
+    if(loop_timer_read(source) == 0) {
+        return;
+    }
+    check_geometry();
+    stats_flush(dpy);
+    async_resolve(&replies, dpy);
+}
+
+void check_geometry_reply(void* data, void* reply) {
+    xcb_window_t window = (xcb_window_t) (uintptr_t) data;
+    xcb_get_geometry_reply_t* geom = reply;
+    int32_t i = client_index(window);
+
+    // Gone in the meantime
+    if(geom == NULL || i < 0) {
+        return;
+    }
+    if(geom->x != store.x[i] || geom->y != store.y[i] || geom->width != store.w[i]
+            || geom->height != store.h[i] || geom->border_width != store.border[i]) {
+        PDEBUG("Stale geometry for 0x%x: cached %dx%d+%dx%d border %d, server %dx%d+%dx%d border %d",
+               window, store.x[i], store.y[i], store.w[i], store.h[i], store.border[i],
+               geom->x, geom->y, geom->width, geom->height, geom->border_width);
+        store_set_geom(&store, i, geom->x, geom->y, geom->width, geom->height);
+        store_set_border(&store, i, geom->border_width);
+    }
 }
+#endif
 
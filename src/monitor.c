@@ -0,0 +1,231 @@
+#include <stdlib.h>
+
+#include "config.h"
+#include "monitor.h"
+#include "stats.h"
+
+#ifdef MULTIHEAD
+#include <xcb/randr.h>
+#include <xcb/xinerama.h>
+#endif
+
+bool monitor_set(struct monitors* monitors, uint32_t id, int16_t x, int16_t y, uint16_t w, uint16_t h) {
+    struct monitor* mon = NULL;
+
+    for(uint32_t i = 0; i < monitors->len; i++) {
+        if(monitors->mons[i].id == id) {
+            mon = &monitors->mons[i];
+            break;
+        }
+    }
+
+    if(mon == NULL) {
+        if(monitors->len == monitors->cap) {
+            uint32_t cap = monitors->cap ? monitors->cap * 2 : 4;
+            struct monitor* mons = realloc(monitors->mons, cap * sizeof(struct monitor));
+
+            if(mons == NULL) {
+                return false;
+            }
+            monitors->mons = mons;
+            monitors->cap = cap;
+        }
+        mon = &monitors->mons[monitors->len++];
+        mon->id = id;
+    }
+
+    mon->x = x;
+    mon->y = y;
+    mon->w = w;
+    mon->h = h;
+
+    return true;
+}
+
+void monitor_remove(struct monitors* monitors, uint32_t id) {
+    for(uint32_t i = 0; i < monitors->len; i++) {
+        if(monitors->mons[i].id == id) {
+            // Order doesn't matter; move the last one in
+            monitors->mons[i] = monitors->mons[--monitors->len];
+            monitors->last = 0;
+            return;
+        }
+    }
+}
+
+static inline bool monitor_holds(const struct monitor* mon, int16_t x, int16_t y) {
+    return (uint32_t) (x - mon->x) < mon->w && (uint32_t) (y - mon->y) < mon->h;
+}
+
+int32_t monitor_at(struct monitors* monitors, int16_t x, int16_t y) {
+    // Even a big docking station setup is a handful of monitors, so a
+    // scan over a flat array beats anything cleverer
+    if(monitors->last < monitors->len && monitor_holds(&monitors->mons[monitors->last], x, y)) {
+        return (int32_t) monitors->last;
+    }
+    for(uint32_t i = 0; i < monitors->len; i++) {
+        if(monitor_holds(&monitors->mons[i], x, y)) {
+            monitors->last = i;
+            return (int32_t) i;
+        }
+    }
+
+    return -1;
+}
+
+int32_t monitor_for_rect(struct monitors* monitors, int16_t x, int16_t y, uint16_t w, uint16_t h) {
+    int32_t best = -1;
+    int64_t best_area = 0;
+
+    for(uint32_t i = 0; i < monitors->len; i++) {
+        const struct monitor* mon = &monitors->mons[i];
+        int32_t x1 = x > mon->x ? x : mon->x;
+        int32_t y1 = y > mon->y ? y : mon->y;
+        int32_t x2 = x + w < mon->x + mon->w ? x + w : mon->x + mon->w;
+        int32_t y2 = y + h < mon->y + mon->h ? y + h : mon->y + mon->h;
+        int64_t area = x2 > x1 && y2 > y1 ? (int64_t) (x2 - x1) * (y2 - y1) : 0;
+
+        if(area > best_area) {
+            best = (int32_t) i;
+            best_area = area;
+        }
+    }
+    if(best < 0) {
+        best = monitor_at(monitors, x + w / 2, y + h / 2);
+    }
+    if(best < 0 && monitors->len > 0) {
+        best = 0;
+    }
+
+    return best;
+}
+
+#ifdef MULTIHEAD
+/*
+ * Fill the table from RandR, asking about every CRTC at once.
+ */
+static bool monitor_init_randr(struct monitors* monitors, xcb_connection_t* dpy, xcb_screen_t* screen) {
+    const xcb_query_extension_reply_t* ext = xcb_get_extension_data(dpy, &xcb_randr_id);
+    xcb_randr_get_screen_resources_current_reply_t* res;
+    xcb_randr_get_crtc_info_cookie_t* cookies;
+    xcb_randr_crtc_t* crtcs;
+    int n;
+
+    if(ext == NULL || !ext->present) {
+        return false;
+    }
+
+    res = stats_reply(xcb_randr_get_screen_resources_current_reply(dpy,
+                      xcb_randr_get_screen_resources_current(dpy, screen->root), NULL));
+    if(res == NULL) {
+        return false;
+    }
+    crtcs = xcb_randr_get_screen_resources_current_crtcs(res);
+    n = xcb_randr_get_screen_resources_current_crtcs_length(res);
+
+    cookies = malloc(n * sizeof(xcb_randr_get_crtc_info_cookie_t));
+    if(cookies == NULL) {
+        stats_reply_free(res);
+        return false;
+    }
+    for(int i = 0; i < n; i++) {
+        cookies[i] = xcb_randr_get_crtc_info(dpy, crtcs[i], res->config_timestamp);
+    }
+    for(int i = 0; i < n; i++) {
+        xcb_randr_get_crtc_info_reply_t* info = stats_reply(xcb_randr_get_crtc_info_reply(dpy, cookies[i], NULL));
+
+        // Disabled CRTCs have no mode
+        if(info != NULL && info->mode != XCB_NONE && info->width > 0 && info->height > 0) {
+            monitor_set(monitors, crtcs[i], info->x, info->y, info->width, info->height);
+        }
+        stats_reply_free(info);
+    }
+    free(cookies);
+    stats_reply_free(res);
+
+    // From now on, changes come to us one CRTC at a time
+    monitors->randr_base = ext->first_event;
+    xcb_randr_select_input(dpy, screen->root,
+                           XCB_RANDR_NOTIFY_MASK_SCREEN_CHANGE | XCB_RANDR_NOTIFY_MASK_CRTC_CHANGE);
+
+    return monitors->len > 0;
+}
+
+static bool monitor_init_xinerama(struct monitors* monitors, xcb_connection_t* dpy) {
+    const xcb_query_extension_reply_t* ext = xcb_get_extension_data(dpy, &xcb_xinerama_id);
+    xcb_xinerama_is_active_reply_t* xia;
+    xcb_xinerama_query_screens_reply_t* xsq;
+    xcb_xinerama_screen_info_t* xsi;
+    bool active = false;
+
+    if(ext == NULL || !ext->present) {
+        return false;
+    }
+
+    xia = stats_reply(xcb_xinerama_is_active_reply(dpy, xcb_xinerama_is_active(dpy), NULL));
+    if(xia) {
+        active = xia->state;
+        stats_reply_free(xia);
+    }
+    if(!active) {
+        return false;
+    }
+
+    xsq = stats_reply(xcb_xinerama_query_screens_reply(dpy, xcb_xinerama_query_screens(dpy), NULL));
+    if(xsq == NULL) {
+        return false;
+    }
+    xsi = xcb_xinerama_query_screens_screen_info(xsq);
+    for(int32_t i = 0; i < xcb_xinerama_query_screens_screen_info_length(xsq); i++) {
+        monitor_set(monitors, i + 1, xsi[i].x_org, xsi[i].y_org, xsi[i].width, xsi[i].height);
+    }
+    stats_reply_free(xsq);
+
+    return monitors->len > 0;
+}
+#endif
+
+void monitor_init(struct monitors* monitors, xcb_connection_t* dpy, xcb_screen_t* screen) {
+#ifdef MULTIHEAD
+    if(monitor_init_randr(monitors, dpy, screen) || monitor_init_xinerama(monitors, dpy)) {
+        return;
+    }
+#endif
+    monitor_set(monitors, 1, 0, 0, screen->width_in_pixels, screen->height_in_pixels);
+}
+
+bool monitor_event(struct monitors* monitors, xcb_screen_t* screen, const xcb_generic_event_t* ev) {
+#ifdef MULTIHEAD
+    uint8_t type = ev->response_type & ~0x80;
+
+    if(monitors->randr_base == 0) {
+        return false;
+    }
+
+    if(type == monitors->randr_base + XCB_RANDR_SCREEN_CHANGE_NOTIFY) {
+        const xcb_randr_screen_change_notify_event_t* e = (const xcb_randr_screen_change_notify_event_t*) ev;
+
+        // Only the root size; the CRTCs tell us about monitors
+        screen->width_in_pixels = e->width;
+        screen->height_in_pixels = e->height;
+        return true;
+    }
+
+    if(type == monitors->randr_base + XCB_RANDR_NOTIFY) {
+        const xcb_randr_notify_event_t* e = (const xcb_randr_notify_event_t*) ev;
+        const xcb_randr_crtc_change_t* cc = &e->u.cc;
+
+        if(e->subCode != XCB_RANDR_NOTIFY_CRTC_CHANGE) {
+            return true;
+        }
+        if(cc->mode == XCB_NONE || cc->width == 0 || cc->height == 0) {
+            monitor_remove(monitors, cc->crtc);
+        } else {
+            monitor_set(monitors, cc->crtc, cc->x, cc->y, cc->width, cc->height);
+        }
+        return true;
+    }
+#endif
+
+    return false;
+}
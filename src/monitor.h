@@ -0,0 +1,74 @@
+#ifndef MONITOR_H
+#define MONITOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <xcb/xcb.h>
+
+/*
+ * Monitor table: the rectangles of the root window that are actually
+ * on some output.
+ *
+ * Filled from RandR when we have it (and kept current from its CRTC
+ * change notifications, one monitor at a time), from Xinerama
+ * otherwise, and as the whole screen if all else fails.
+ */
+
+struct monitor {
+    /* RandR CRTC, or some other unique nonzero ID without RandR */
+    uint32_t id;
+    int16_t x;
+    int16_t y;
+    uint16_t w;
+    uint16_t h;
+};
+
+struct monitors {
+    struct monitor* mons;
+    uint32_t len;
+    uint32_t cap;
+    /* Index of the last lookup hit. Lookups cluster, so try it first. */
+    uint32_t last;
+    /* First RandR event code, or 0 if we don't listen to RandR */
+    uint8_t randr_base;
+};
+
+#define MONITORS_INIT { NULL, 0, 0, 0, 0 }
+
+/*
+ * Fill the table for screen, and ask for updates when outputs change.
+ */
+void monitor_init(struct monitors* monitors, xcb_connection_t* dpy, xcb_screen_t* screen);
+
+/*
+ * Add the monitor with id, or update it if it's already known.
+ *
+ * Returns false if out of memory.
+ */
+bool monitor_set(struct monitors* monitors, uint32_t id, int16_t x, int16_t y, uint16_t w, uint16_t h);
+
+/*
+ * Forget the monitor with id.
+ */
+void monitor_remove(struct monitors* monitors, uint32_t id);
+
+/*
+ * Index of the monitor holding the point (x, y), or -1 if it's off
+ * every monitor.
+ */
+int32_t monitor_at(struct monitors* monitors, int16_t x, int16_t y);
+
+/*
+ * Index of the monitor that has the most of the rectangle on it, or the
+ * one holding its center if it's on none of them. -1 if there are no
+ * monitors.
+ */
+int32_t monitor_for_rect(struct monitors* monitors, int16_t x, int16_t y, uint16_t w, uint16_t h);
+
+/*
+ * Apply a RandR notification. Returns false if ev isn't one.
+ */
+bool monitor_event(struct monitors* monitors, xcb_screen_t* screen, const xcb_generic_event_t* ev);
+
+#endif /* MONITOR_H */
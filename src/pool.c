@@ -0,0 +1,73 @@
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "pool.h"
+
+/*
+ * A chunk starts with a pointer to the next chunk, padded out to one
+ * object so the objects after it stay aligned.
+ */
+static bool pool_grow(struct pool* pool) {
+    char* chunk;
+
+    chunk = malloc(pool->size * (pool->per_chunk + 1));
+    if(chunk == NULL) {
+        return false;
+    }
+    pool->heap_allocs++;
+
+    *(void**) chunk = pool->chunks;
+    pool->chunks = chunk;
+
+    for(size_t i = pool->per_chunk; i > 0; i--) {
+        void* object = chunk + i * pool->size;
+
+        *(void**) object = pool->free;
+        pool->free = object;
+    }
+
+    return true;
+}
+
+void* pool_alloc(struct pool* pool) {
+    void* object;
+
+    if(pool->free == NULL && !pool_grow(pool)) {
+        return NULL;
+    }
+
+    object = pool->free;
+    pool->free = *(void**) object;
+    pool->allocs++;
+
+    return object;
+}
+
+void pool_free(struct pool* pool, void* object) {
+    if(object == NULL) {
+        return;
+    }
+
+    *(void**) object = pool->free;
+    pool->free = object;
+    pool->frees++;
+}
+
+void pool_destroy(struct pool* pool) {
+    void* next;
+
+    for(void* chunk = pool->chunks; chunk != NULL; chunk = next) {
+        next = *(void**) chunk;
+        free(chunk);
+    }
+    pool->chunks = NULL;
+    pool->free = NULL;
+}
+
+void pool_print(FILE* out, const char* name, const struct pool* pool) {
+    fprintf(out, "%s: %llu live, %llu allocs, %llu frees, %llu heap allocations\n", name,
+            (unsigned long long) (pool->allocs - pool->frees),
+            (unsigned long long) pool->allocs,
+            (unsigned long long) pool->frees,
+            (unsigned long long) pool->heap_allocs);
+}
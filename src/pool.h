@@ -0,0 +1,57 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * Fixed-size object pool.
+ *
+ * Objects are carved out of chunks that are never given back to the
+ * heap while the pool lives. Freed objects go on a freelist and are
+ * handed out again first, so once the pool has grown to the peak
+ * number of live objects, allocating and freeing never touch malloc.
+ */
+
+struct pool {
+    /* Size of one object, rounded up to pointer alignment */
+    size_t size;
+    /* Objects per chunk */
+    size_t per_chunk;
+    /* Free objects, linked through their first word */
+    void* free;
+    /* All chunks, linked through their first word */
+    void* chunks;
+    /* Times the pool had to go to the heap for a new chunk */
+    uint64_t heap_allocs;
+    /* Objects handed out and given back */
+    uint64_t allocs;
+    uint64_t frees;
+};
+
+#define POOL_INIT(type, n) { \
+    ((sizeof(type) + sizeof(void*) - 1) / sizeof(void*)) * sizeof(void*), \
+    (n), NULL, NULL, 0, 0, 0 }
+
+/*
+ * Get an uninitialized object. Returns NULL if out of memory.
+ */
+void* pool_alloc(struct pool* pool);
+
+/*
+ * Give object back to the pool. object may be NULL.
+ */
+void pool_free(struct pool* pool, void* object);
+
+/*
+ * Free all chunks. Every object from the pool becomes invalid.
+ */
+void pool_destroy(struct pool* pool);
+
+/*
+ * Print the counters of pool to out.
+ */
+void pool_print(FILE* out, const char* name, const struct pool* pool);
+
+#endif /* POOL_H */
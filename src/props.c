@@ -0,0 +1,337 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "atoms.h"
+#include "pool.h"
+#include "props.h"
+#include "stats.h"
+
+/* Where the entries of every cache come from */
+static struct pool props_pool = POOL_INIT(struct props, 64);
+
+/*
+ * Property to ask for, its type, and how many 32-bit units of it we
+ * read. Strings are read whole.
+ */
+static xcb_atom_t prop_atom(enum prop_id id) {
+    switch(id) {
+    case PROP_NET_WM_NAME:
+        return atoms[ATOM__NET_WM_NAME];
+    case PROP_WM_NAME:
+        return XCB_ATOM_WM_NAME;
+    case PROP_WM_CLASS:
+        return XCB_ATOM_WM_CLASS;
+    case PROP_WM_NORMAL_HINTS:
+        return XCB_ATOM_WM_NORMAL_HINTS;
+    case PROP_WM_HINTS:
+        return XCB_ATOM_WM_HINTS;
+    case PROP_WM_TRANSIENT_FOR:
+        return XCB_ATOM_WM_TRANSIENT_FOR;
+    default:
+        return XCB_NONE;
+    }
+}
+
+static xcb_atom_t prop_type(enum prop_id id) {
+    switch(id) {
+    case PROP_NET_WM_NAME:
+        return atoms[ATOM_UTF8_STRING];
+    case PROP_WM_NAME:
+    case PROP_WM_CLASS:
+        // Could be STRING or COMPOUND_TEXT; take either
+        return XCB_GET_PROPERTY_TYPE_ANY;
+    case PROP_WM_NORMAL_HINTS:
+        return XCB_ATOM_WM_SIZE_HINTS;
+    case PROP_WM_HINTS:
+        return XCB_ATOM_WM_HINTS;
+    case PROP_WM_TRANSIENT_FOR:
+        return XCB_ATOM_WINDOW;
+    default:
+        return XCB_NONE;
+    }
+}
+
+static uint32_t prop_length(enum prop_id id) {
+    switch(id) {
+    case PROP_WM_NORMAL_HINTS:
+        return sizeof(struct prop_size_hints) / 4;
+    case PROP_WM_HINTS:
+        return sizeof(struct prop_wm_hints) / 4;
+    case PROP_WM_TRANSIENT_FOR:
+        return 1;
+    default:
+        // Longer titles than this are someone's idea of a joke
+        return 1024;
+    }
+}
+
+/*
+ * Free a string from prop_string().
+ */
+static void prop_string_free(char* s) {
+    if(s != NULL) {
+        free(s);
+        stats_free(STATS_MEM_CLIENTS);
+    }
+}
+
+static void props_clear(struct props* props, enum prop_id id) {
+    switch(id) {
+    case PROP_NET_WM_NAME:
+        prop_string_free(props->net_wm_name);
+        props->net_wm_name = NULL;
+        break;
+    case PROP_WM_NAME:
+        prop_string_free(props->wm_name);
+        props->wm_name = NULL;
+        break;
+    case PROP_WM_CLASS:
+        prop_string_free(props->wm_class);
+        props->wm_class = NULL;
+        props->wm_class_len = 0;
+        break;
+    case PROP_WM_NORMAL_HINTS:
+        memset(&props->normal_hints, 0, sizeof(props->normal_hints));
+        break;
+    case PROP_WM_HINTS:
+        memset(&props->hints, 0, sizeof(props->hints));
+        break;
+    case PROP_WM_TRANSIENT_FOR:
+        props->transient_for = XCB_NONE;
+        break;
+    default:
+        break;
+    }
+}
+
+static void props_destroy(struct props* props) {
+    for(int i = 0; i < PROP_COUNT; i++) {
+        props_clear(props, i);
+    }
+    pool_free(&props_pool, props);
+    stats_free(STATS_MEM_CLIENTS);
+}
+
+/*
+ * Copy of a string property, NUL-terminated. Sets len to its length
+ * without the terminator.
+ */
+static char* prop_string(xcb_get_property_reply_t* prop, uint32_t* len) {
+    int n = xcb_get_property_value_length(prop);
+    char* s;
+
+    if(prop->format != 8 || n <= 0 || (s = malloc(n + 1)) == NULL) {
+        return NULL;
+    }
+    stats_alloc(STATS_MEM_CLIENTS);
+    memcpy(s, xcb_get_property_value(prop), n);
+    s[n] = '\0';
+    if(len) {
+        *len = n;
+    }
+
+    return s;
+}
+
+static void props_reply(struct props* props, enum prop_id id, xcb_get_property_reply_t* prop) {
+    uint8_t bit = PROP_BIT(id);
+    int n;
+
+    props->fetching[id]--;
+    if(props->dead) {
+        return;
+    }
+    // Changed while on its way, so it may say what was there before.
+    // If it was wanted since, a fresh fetch is right behind it.
+    if(props->outdated[id] > 0) {
+        props->outdated[id]--;
+        return;
+    }
+    props_clear(props, id);
+    props->valid |= bit;
+    if(prop == NULL || prop->type == XCB_NONE) {
+        return;
+    }
+
+    n = xcb_get_property_value_length(prop);
+    switch(id) {
+    case PROP_NET_WM_NAME:
+        props->net_wm_name = prop_string(prop, NULL);
+        break;
+    case PROP_WM_NAME:
+        props->wm_name = prop_string(prop, NULL);
+        break;
+    case PROP_WM_CLASS:
+        props->wm_class = prop_string(prop, &props->wm_class_len);
+        break;
+    case PROP_WM_NORMAL_HINTS:
+        // Old clients send fewer fields; the rest stay zero
+        if(prop->format == 32) {
+            memcpy(&props->normal_hints, xcb_get_property_value(prop),
+                   (size_t) n < sizeof(props->normal_hints) ? (size_t) n : sizeof(props->normal_hints));
+        }
+        break;
+    case PROP_WM_HINTS:
+        if(prop->format == 32) {
+            memcpy(&props->hints, xcb_get_property_value(prop),
+                   (size_t) n < sizeof(props->hints) ? (size_t) n : sizeof(props->hints));
+        }
+        break;
+    case PROP_WM_TRANSIENT_FOR:
+        if(prop->format == 32 && n >= 4) {
+            props->transient_for = *(xcb_window_t*) xcb_get_property_value(prop);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+/*
+ * Continuations, one per property, so the entry is all they need to
+ * carry. An entry forgotten while they were out goes with the last.
+ */
+#define PROPS_REPLY(id) \
+    static void props_reply_##id(void* data, void* reply) { \
+        struct props* props = data; \
+        props->inflight--; \
+        props_reply(props, id, reply); \
+        if(props->dead && props->inflight == 0) { \
+            props_destroy(props); \
+        } \
+    }
+
+PROPS_REPLY(PROP_NET_WM_NAME)
+PROPS_REPLY(PROP_WM_NAME)
+PROPS_REPLY(PROP_WM_CLASS)
+PROPS_REPLY(PROP_WM_NORMAL_HINTS)
+PROPS_REPLY(PROP_WM_HINTS)
+PROPS_REPLY(PROP_WM_TRANSIENT_FOR)
+
+static const async_cb props_replies[PROP_COUNT] = {
+    props_reply_PROP_NET_WM_NAME,
+    props_reply_PROP_WM_NAME,
+    props_reply_PROP_WM_CLASS,
+    props_reply_PROP_WM_NORMAL_HINTS,
+    props_reply_PROP_WM_HINTS,
+    props_reply_PROP_WM_TRANSIENT_FOR
+};
+
+struct props* props_get(struct propcache* cache, xcb_window_t window) {
+    struct props* props = wintable_get(&cache->windows, window);
+
+    if(props != NULL) {
+        return props;
+    }
+    if((props = pool_alloc(&props_pool)) == NULL) {
+        return NULL;
+    }
+    stats_alloc(STATS_MEM_CLIENTS);
+    memset(props, 0, sizeof(struct props));
+    props->cache = cache;
+    props->window = window;
+    if(!wintable_put(&cache->windows, window, props)) {
+        pool_free(&props_pool, props);
+        stats_free(STATS_MEM_CLIENTS);
+        return NULL;
+    }
+
+    return props;
+}
+
+bool props_want(struct props* props, xcb_connection_t* dpy, struct async_queue* replies, uint32_t mask) {
+    uint32_t missing = mask & ~props->valid;
+
+    props->cache->hits += __builtin_popcount(mask & props->valid);
+    if(missing == 0) {
+        return true;
+    }
+    for(int i = 0; i < PROP_COUNT; i++) {
+        xcb_get_property_cookie_t cookie;
+
+        // Already asked for, after the last change
+        if(!(missing & PROP_BIT(i)) || props->fetching[i] > props->outdated[i]) {
+            continue;
+        }
+        cookie = xcb_get_property(dpy, 0, props->window, prop_atom(i), prop_type(i), 0, prop_length(i));
+        if(!async_push(replies, dpy, cookie.sequence, props_replies[i], props)) {
+            continue;
+        }
+        props->fetching[i]++;
+        props->inflight++;
+        props->cache->fetches++;
+    }
+
+    return false;
+}
+
+const char* props_name(const struct props* props) {
+    if(props->net_wm_name != NULL) {
+        return props->net_wm_name;
+    }
+    return props->wm_name;
+}
+
+bool props_changed(struct propcache* cache, xcb_window_t window, xcb_atom_t atom) {
+    struct props* props;
+    int i;
+
+    for(i = 0; i < PROP_COUNT; i++) {
+        if(prop_atom(i) == atom) {
+            break;
+        }
+    }
+    if(i == PROP_COUNT) {
+        return false;
+    }
+    // Never wanted, so nothing to throw out
+    if((props = wintable_get(&cache->windows, window)) == NULL) {
+        return true;
+    }
+    if((props->valid & PROP_BIT(i)) || props->fetching[i] > 0) {
+        cache->invalidations++;
+    }
+    props->valid &= ~PROP_BIT(i);
+    props->outdated[i] = props->fetching[i];
+    props_clear(props, i);
+
+    return true;
+}
+
+void props_forget(struct propcache* cache, xcb_window_t window) {
+    struct props* props = wintable_del(&cache->windows, window);
+
+    if(props == NULL) {
+        return;
+    }
+    // Replies still point at it
+    if(props->inflight != 0) {
+        props->dead = true;
+        return;
+    }
+    props_destroy(props);
+}
+
+void props_free(struct propcache* cache) {
+    for(uint32_t i = 0; i < cache->windows.size; i++) {
+        struct props* props = cache->windows.slots[i].value;
+
+        if(cache->windows.slots[i].key == XCB_NONE) {
+            continue;
+        }
+        if(props->inflight != 0) {
+            props->dead = true;
+        } else {
+            props_destroy(props);
+        }
+    }
+    wintable_free(&cache->windows);
+}
+
+void props_print(FILE* out, const struct propcache* cache) {
+    fprintf(out, "properties: %u windows, %llu fetches, %llu hits, %llu invalidations\n",
+            cache->windows.count,
+            (unsigned long long) cache->fetches,
+            (unsigned long long) cache->hits,
+            (unsigned long long) cache->invalidations);
+}
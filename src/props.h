@@ -0,0 +1,172 @@
+#ifndef PROPS_H
+#define PROPS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <xcb/xcb.h>
+
+#include "async.h"
+#include "wintable.h"
+
+/*
+ * Cache of the client window properties we care about.
+ *
+ * Nothing is fetched until something wants it. props_want() sends a
+ * GetProperty for each property asked for that isn't cached yet, and
+ * the replies come in with everything else at the end of the batch,
+ * so wanting five properties of a window costs the same round trip as
+ * wanting one.
+ *
+ * A PropertyNotify for one of them only marks that one stale. It isn't
+ * fetched again until it's wanted again, so a client retitling itself
+ * every frame costs us a bit flip per change.
+ */
+
+enum prop_id {
+    PROP_NET_WM_NAME,
+    PROP_WM_NAME,
+    PROP_WM_CLASS,
+    PROP_WM_NORMAL_HINTS,
+    PROP_WM_HINTS,
+    PROP_WM_TRANSIENT_FOR,
+    PROP_COUNT
+};
+
+#define PROP_BIT(id) (1u << (id))
+
+/* The title, whichever of the two the client sets */
+#define PROP_NAMES (PROP_BIT(PROP_NET_WM_NAME) | PROP_BIT(PROP_WM_NAME))
+
+/* WM_NORMAL_HINTS, laid out as ICCCM has it */
+struct prop_size_hints {
+    uint32_t flags;
+    /* Obsolete */
+    int32_t x, y, width, height;
+    int32_t min_width, min_height;
+    int32_t max_width, max_height;
+    int32_t width_inc, height_inc;
+    int32_t min_aspect_num, min_aspect_den;
+    int32_t max_aspect_num, max_aspect_den;
+    int32_t base_width, base_height;
+    uint32_t win_gravity;
+};
+
+/* Which fields of WM_NORMAL_HINTS are set */
+#define PROP_SIZE_HINT_MIN_SIZE (1 << 4)
+#define PROP_SIZE_HINT_MAX_SIZE (1 << 5)
+#define PROP_SIZE_HINT_RESIZE_INC (1 << 6)
+#define PROP_SIZE_HINT_BASE_SIZE (1 << 8)
+
+/* WM_HINTS, laid out as ICCCM has it */
+struct prop_wm_hints {
+    uint32_t flags;
+    uint32_t input;
+    uint32_t initial_state;
+    uint32_t icon_pixmap;
+    uint32_t icon_window;
+    int32_t icon_x, icon_y;
+    uint32_t icon_mask;
+    uint32_t window_group;
+};
+
+/* Which fields of WM_HINTS are set */
+#define PROP_WM_HINT_INPUT (1 << 0)
+#define PROP_WM_HINT_STATE (1 << 1)
+#define PROP_WM_HINT_URGENCY (1 << 8)
+
+struct propcache;
+
+struct props {
+    struct propcache* cache;
+    xcb_window_t window;
+    /* Bit per prop_id: the copy here is current */
+    uint8_t valid;
+    /* Per prop_id: fetches on their way, and how many of those went
+     * out before the property last changed */
+    uint8_t fetching[PROP_COUNT];
+    uint8_t outdated[PROP_COUNT];
+    /* Replies still to come, whatever they're for */
+    uint8_t inflight;
+    /* Forgotten with fetches still out; freed with the last reply */
+    bool dead;
+    /* Titles, NUL-terminated, or NULL if unset */
+    char* net_wm_name;
+    char* wm_name;
+    /* Instance and class, each NUL-terminated, back to back, or NULL */
+    char* wm_class;
+    uint32_t wm_class_len;
+    /* All zeros if unset */
+    struct prop_size_hints normal_hints;
+    struct prop_wm_hints hints;
+    /* XCB_NONE if unset */
+    xcb_window_t transient_for;
+};
+
+struct propcache {
+    /* Window -> props */
+    struct wintable windows;
+    /* Properties asked of the server, and found cached */
+    uint64_t fetches;
+    uint64_t hits;
+    /* Cached properties thrown out by a PropertyNotify */
+    uint64_t invalidations;
+};
+
+#define PROPCACHE_INIT { WINTABLE_INIT, 0, 0, 0 }
+
+/*
+ * The cache entry of window, made empty if there isn't one. Returns
+ * NULL if out of memory.
+ */
+struct props* props_get(struct propcache* cache, xcb_window_t window);
+
+/*
+ * The cache entry of window, or NULL if nothing was ever wanted of it.
+ */
+static inline struct props* props_find(struct propcache* cache, xcb_window_t window) {
+    return wintable_get(&cache->windows, window);
+}
+
+/*
+ * Fetch the properties in mask (PROP_BIT()s) that aren't cached, in
+ * the background. They're in once replies are resolved.
+ *
+ * Returns true if all of them are cached already.
+ */
+bool props_want(struct props* props, xcb_connection_t* dpy, struct async_queue* replies, uint32_t mask);
+
+/*
+ * Are all the properties in mask cached?
+ */
+static inline bool props_have(const struct props* props, uint32_t mask) {
+    return (props->valid & mask) == mask;
+}
+
+/*
+ * The window's title, or NULL if it has none or it isn't cached.
+ */
+const char* props_name(const struct props* props);
+
+/*
+ * Property atom of window changed. Returns true if it was one we cache.
+ */
+bool props_changed(struct propcache* cache, xcb_window_t window, xcb_atom_t atom);
+
+/*
+ * Drop window's entry.
+ */
+void props_forget(struct propcache* cache, xcb_window_t window);
+
+/*
+ * Drop every entry.
+ */
+void props_free(struct propcache* cache);
+
+/*
+ * Print the counters of cache to out.
+ */
+void props_print(FILE* out, const struct propcache* cache);
+
+#endif /* PROPS_H */
@@ -0,0 +1,111 @@
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "snapshot.h"
+
+/*
+ * Write all of len bytes, or fail.
+ */
+static bool snapshot_put(int fd, const void* buf, size_t len) {
+    const uint8_t* p = buf;
+
+    while(len > 0) {
+        ssize_t n = write(fd, p, len);
+
+        if(n <= 0) {
+            return false;
+        }
+        p += n;
+        len -= n;
+    }
+
+    return true;
+}
+
+static bool snapshot_get(int fd, void* buf, size_t len) {
+    uint8_t* p = buf;
+
+    while(len > 0) {
+        ssize_t n = read(fd, p, len);
+
+        if(n <= 0) {
+            return false;
+        }
+        p += n;
+        len -= n;
+    }
+
+    return true;
+}
+
+int snapshot_write(uint32_t workspace, const struct snapshot_client* clients, uint32_t n) {
+    struct snapshot_header header;
+    // Not MFD_CLOEXEC: the whole point is for exec to keep it
+    int fd = memfd_create("qtwm-snapshot", 0);
+
+    if(fd < 0) {
+        return -1;
+    }
+
+    header.magic = SNAPSHOT_MAGIC;
+    header.version = SNAPSHOT_VERSION;
+    header.client_size = sizeof(struct snapshot_client);
+    header.count = n;
+    header.workspace = workspace;
+    if(!snapshot_put(fd, &header, sizeof(header))
+            || !snapshot_put(fd, clients, n * sizeof(struct snapshot_client))
+            || lseek(fd, 0, SEEK_SET) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+bool snapshot_read(struct snapshot* snapshot, int fd) {
+    struct snapshot_header* header = &snapshot->header;
+
+    if(!snapshot_get(fd, header, sizeof(*header))
+            || header->magic != SNAPSHOT_MAGIC
+            || header->version != SNAPSHOT_VERSION
+            || header->client_size != sizeof(struct snapshot_client)) {
+        close(fd);
+        return false;
+    }
+
+    snapshot->clients = malloc(header->count * sizeof(struct snapshot_client));
+    if(snapshot->clients == NULL && header->count > 0) {
+        close(fd);
+        return false;
+    }
+    if(!snapshot_get(fd, snapshot->clients, header->count * sizeof(struct snapshot_client))) {
+        close(fd);
+        snapshot_free(snapshot);
+        return false;
+    }
+    close(fd);
+
+    wintable_reserve(&snapshot->index, header->count);
+    for(uint32_t i = 0; i < header->count; i++) {
+        if(snapshot->clients[i].window == XCB_NONE) {
+            continue;
+        }
+        if(!wintable_put(&snapshot->index, snapshot->clients[i].window, &snapshot->clients[i])) {
+            snapshot_free(snapshot);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void snapshot_free(struct snapshot* snapshot) {
+    free(snapshot->clients);
+    snapshot->clients = NULL;
+    snapshot->header.count = 0;
+    wintable_free(&snapshot->index);
+}
@@ -0,0 +1,80 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <xcb/xcb.h>
+
+#include "wintable.h"
+
+/*
+ * What a restarting qtwm hands to the one it execs: which windows it
+ * managed and what it knew about them that the server doesn't.
+ *
+ * The snapshot lives in a memfd that survives exec, and its number is
+ * passed on the command line. Geometry is not in it; the new process
+ * asks the server for that anyway, while making sure the windows are
+ * still there. Neither are flags and such that come from the window's
+ * properties.
+ */
+
+#define SNAPSHOT_MAGIC 0x71747731 /* "qtw1" */
+#define SNAPSHOT_VERSION 1
+
+struct snapshot_header {
+    uint32_t magic;
+    uint16_t version;
+    /* sizeof(struct snapshot_client) of the writer */
+    uint16_t client_size;
+    uint32_t count;
+    /* Workspace on screen */
+    uint32_t workspace;
+};
+
+struct snapshot_client {
+    xcb_window_t window;
+    uint32_t workspace;
+    /* Place in the focus order, 0 being the focused window */
+    uint32_t mru;
+    /* Was in a tiling layout */
+    uint8_t tiled;
+    uint8_t pad[3];
+    /* Last value we asked its sync counter to reach */
+    uint64_t sync_value;
+};
+
+struct snapshot {
+    struct snapshot_header header;
+    /* Oldest managed window first, as in _NET_CLIENT_LIST */
+    struct snapshot_client* clients;
+    /* Window -> its entry in clients */
+    struct wintable index;
+};
+
+#define SNAPSHOT_INIT { { 0, 0, 0, 0, 0 }, NULL, WINTABLE_INIT }
+
+/*
+ * Write a snapshot of n clients to a new memfd that isn't closed on
+ * exec, and rewind it.
+ *
+ * Returns the fd, or -1 on error.
+ */
+int snapshot_write(uint32_t workspace, const struct snapshot_client* clients, uint32_t n);
+
+/*
+ * Read the snapshot in fd, and close fd. Returns false if it isn't one
+ * we understand, or out of memory.
+ */
+bool snapshot_read(struct snapshot* snapshot, int fd);
+
+/*
+ * The entry of window, or NULL if it wasn't managed.
+ */
+static inline const struct snapshot_client* snapshot_find(const struct snapshot* snapshot, xcb_window_t window) {
+    return wintable_get(&snapshot->index, window);
+}
+
+void snapshot_free(struct snapshot* snapshot);
+
+#endif /* SNAPSHOT_H */
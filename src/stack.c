@@ -0,0 +1,127 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "stack.h"
+
+int64_t stack_index(const struct stack* stack, xcb_window_t window) {
+    // What gets restacked is mostly near the top
+    for(int64_t i = (int64_t) stack->len - 1; i >= 0; i--) {
+        if(stack->ids[i] == window) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static void stack_delete(struct stack* stack, uint32_t i) {
+    memmove(&stack->ids[i], &stack->ids[i + 1], (stack->len - i - 1) * sizeof(xcb_window_t));
+    stack->len--;
+}
+
+static bool stack_insert(struct stack* stack, uint32_t i, xcb_window_t window) {
+    if(stack->len == stack->cap) {
+        uint32_t cap = stack->cap ? stack->cap * 2 : 64;
+        xcb_window_t* ids = realloc(stack->ids, cap * sizeof(xcb_window_t));
+
+        if(ids == NULL) {
+            return false;
+        }
+        stack->ids = ids;
+        stack->cap = cap;
+    }
+    memmove(&stack->ids[i + 1], &stack->ids[i], (stack->len - i) * sizeof(xcb_window_t));
+    stack->ids[i] = window;
+    stack->len++;
+
+    return true;
+}
+
+bool stack_push(struct stack* stack, xcb_window_t window) {
+    stack_remove(stack, window);
+    return stack_insert(stack, stack->len, window);
+}
+
+void stack_remove(struct stack* stack, xcb_window_t window) {
+    int64_t i = stack_index(stack, window);
+
+    if(i >= 0) {
+        stack_delete(stack, (uint32_t) i);
+    }
+}
+
+bool stack_place(struct stack* stack, xcb_window_t window, xcb_window_t sibling, uint32_t mode) {
+    int64_t i = stack_index(stack, window);
+    int64_t s;
+    int64_t to;
+
+    if(i < 0) {
+        return false;
+    }
+    if(sibling == XCB_NONE) {
+        to = mode == XCB_STACK_MODE_ABOVE ? (int64_t) stack->len - 1 : 0;
+    } else {
+        if((s = stack_index(stack, sibling)) < 0 || s == i) {
+            return false;
+        }
+        // Where it ends up once it's out of the way
+        if(s > i) {
+            s--;
+        }
+        to = mode == XCB_STACK_MODE_ABOVE ? s + 1 : s;
+    }
+    if(to == i) {
+        return false;
+    }
+    stack_delete(stack, (uint32_t) i);
+    // Can't fail: there's room, it was just in there
+    stack_insert(stack, (uint32_t) to, window);
+
+    return true;
+}
+
+unsigned int stack_raise(struct stack* stack, xcb_connection_t* dpy,
+                         const xcb_window_t* windows, uint32_t n, unsigned int* first) {
+    unsigned int sequence = 0;
+    uint32_t m = 0;
+
+    *first = 0;
+    // Whatever is on top already, in the right order, stays put
+    while(m < n && m < stack->len && stack->ids[stack->len - 1 - m] == windows[n - 1 - m]) {
+        m++;
+    }
+
+    // Top down, each under the one that belongs above it
+    for(int64_t i = (int64_t) n - 1 - m; i >= 0; i--) {
+        uint32_t values[2];
+        uint16_t mask = XCB_CONFIG_WINDOW_STACK_MODE;
+        xcb_window_t above = i + 1 < n ? windows[i + 1] : XCB_NONE;
+        int64_t at = stack_index(stack, windows[i]);
+
+        if(above == XCB_NONE) {
+            values[0] = XCB_STACK_MODE_ABOVE;
+        } else {
+            // Right below it already
+            if(at >= 0 && at + 1 < stack->len && stack->ids[at + 1] == above) {
+                continue;
+            }
+            mask |= XCB_CONFIG_WINDOW_SIBLING;
+            values[0] = above;
+            values[1] = XCB_STACK_MODE_BELOW;
+        }
+        sequence = xcb_configure_window(dpy, windows[i], mask, values).sequence;
+        if(*first == 0) {
+            *first = sequence;
+        }
+        stack_place(stack, windows[i], above, above == XCB_NONE ? XCB_STACK_MODE_ABOVE : XCB_STACK_MODE_BELOW);
+    }
+
+    return sequence;
+}
+
+void stack_free(struct stack* stack) {
+    free(stack->ids);
+    stack->ids = NULL;
+    stack->len = 0;
+    stack->cap = 0;
+}
@@ -0,0 +1,80 @@
+#ifndef STACK_H
+#define STACK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <xcb/xcb.h>
+
+/*
+ * Our copy of the stacking order of the root's children, managed or
+ * not, bottom to top.
+ *
+ * It starts out from QueryTree, and is kept current from CreateNotify,
+ * DestroyNotify, ReparentNotify and the above_sibling of every
+ * ConfigureNotify, and right away from our own restacks. That's enough
+ * to skip raising what's already on top, and to say what's at a point
+ * without asking the server.
+ */
+
+struct stack {
+    xcb_window_t* ids;
+    uint32_t len;
+    uint32_t cap;
+};
+
+#define STACK_INIT { NULL, 0, 0 }
+
+/*
+ * Put window on top, taking it from wherever it was. Returns false if
+ * out of memory.
+ */
+bool stack_push(struct stack* stack, xcb_window_t window);
+
+/*
+ * Take window out.
+ */
+void stack_remove(struct stack* stack, xcb_window_t window);
+
+/*
+ * Position of window from the bottom, or -1 if it isn't there.
+ */
+int64_t stack_index(const struct stack* stack, xcb_window_t window);
+
+/*
+ * Restack window the way a ConfigureWindow with sibling and mode
+ * (XCB_STACK_MODE_ABOVE or _BELOW) does. sibling may be XCB_NONE, for
+ * the very top or bottom.
+ *
+ * Returns true if the order changed.
+ */
+bool stack_place(struct stack* stack, xcb_window_t window, xcb_window_t sibling, uint32_t mode);
+
+/*
+ * Topmost window, or XCB_NONE.
+ */
+static inline xcb_window_t stack_top(const struct stack* stack) {
+    return stack->len > 0 ? stack->ids[stack->len - 1] : XCB_NONE;
+}
+
+/*
+ * Put windows on top, windows[n - 1] topmost, each right on top of the
+ * one before. Only windows not already where they belong get a
+ * ConfigureWindow, relative to their neighbour. Does not flush.
+ *
+ * Returns the sequence number of the last request sent, and stores the
+ * first one's in first. Returns 0 if nothing had to move.
+ */
+unsigned int stack_raise(struct stack* stack, xcb_connection_t* dpy,
+                         const xcb_window_t* windows, uint32_t n, unsigned int* first);
+
+/*
+ * Take every window out, keeping the memory.
+ */
+static inline void stack_clear(struct stack* stack) {
+    stack->len = 0;
+}
+
+void stack_free(struct stack* stack);
+
+#endif /* STACK_H */
@@ -0,0 +1,178 @@
+#include <malloc.h>
+#include <unistd.h>
+
+#include "stats.h"
+
+struct stats stats;
+
+static const char* event_names[] = {
+    [XCB_KEY_PRESS] = "KeyPress",
+    [XCB_KEY_RELEASE] = "KeyRelease",
+    [XCB_BUTTON_PRESS] = "ButtonPress",
+    [XCB_BUTTON_RELEASE] = "ButtonRelease",
+    [XCB_MOTION_NOTIFY] = "MotionNotify",
+    [XCB_ENTER_NOTIFY] = "EnterNotify",
+    [XCB_LEAVE_NOTIFY] = "LeaveNotify",
+    [XCB_FOCUS_IN] = "FocusIn",
+    [XCB_FOCUS_OUT] = "FocusOut",
+    [XCB_KEYMAP_NOTIFY] = "KeymapNotify",
+    [XCB_EXPOSE] = "Expose",
+    [XCB_GRAPHICS_EXPOSURE] = "GraphicsExposure",
+    [XCB_NO_EXPOSURE] = "NoExposure",
+    [XCB_VISIBILITY_NOTIFY] = "VisibilityNotify",
+    [XCB_CREATE_NOTIFY] = "CreateNotify",
+    [XCB_DESTROY_NOTIFY] = "DestroyNotify",
+    [XCB_UNMAP_NOTIFY] = "UnmapNotify",
+    [XCB_MAP_NOTIFY] = "MapNotify",
+    [XCB_MAP_REQUEST] = "MapRequest",
+    [XCB_REPARENT_NOTIFY] = "ReparentNotify",
+    [XCB_CONFIGURE_NOTIFY] = "ConfigureNotify",
+    [XCB_CONFIGURE_REQUEST] = "ConfigureRequest",
+    [XCB_GRAVITY_NOTIFY] = "GravityNotify",
+    [XCB_RESIZE_REQUEST] = "ResizeRequest",
+    [XCB_CIRCULATE_NOTIFY] = "CirculateNotify",
+    [XCB_CIRCULATE_REQUEST] = "CirculateRequest",
+    [XCB_PROPERTY_NOTIFY] = "PropertyNotify",
+    [XCB_SELECTION_CLEAR] = "SelectionClear",
+    [XCB_SELECTION_REQUEST] = "SelectionRequest",
+    [XCB_SELECTION_NOTIFY] = "SelectionNotify",
+    [XCB_COLORMAP_NOTIFY] = "ColormapNotify",
+    [XCB_CLIENT_MESSAGE] = "ClientMessage",
+    [XCB_MAPPING_NOTIFY] = "MappingNotify",
+};
+
+static const char* mem_names[STATS_MEM_KINDS] = {
+    [STATS_MEM_EVENTS] = "events",
+    [STATS_MEM_REPLIES] = "replies",
+    [STATS_MEM_CLIENTS] = "clients",
+};
+
+/*
+ * Resident set size in kilobytes, or 0 if unknown.
+ */
+static uint64_t rss_kb(void) {
+    FILE* statm = fopen("/proc/self/statm", "r");
+    unsigned long long size, resident = 0;
+
+    if(statm == NULL) {
+        return 0;
+    }
+    if(fscanf(statm, "%llu %llu", &size, &resident) != 2) {
+        resident = 0;
+    }
+    fclose(statm);
+
+    return resident * (uint64_t) sysconf(_SC_PAGESIZE) / 1024;
+}
+
+static void hist_add(struct stats_hist* hist, uint64_t ns) {
+    uint64_t us = ns / 1000;
+    uint32_t bucket = 0;
+
+    while(bucket < STATS_BUCKETS - 1 && us >= ((uint64_t) 1 << bucket)) {
+        bucket++;
+    }
+
+    hist->count++;
+    hist->total_ns += ns;
+    if(ns > hist->max_ns) {
+        hist->max_ns = ns;
+    }
+    hist->buckets[bucket]++;
+}
+
+/*
+ * Upper bound, in microseconds, of the bucket holding percentile p.
+ */
+static uint64_t hist_percentile(const struct stats_hist* hist, uint32_t p) {
+    uint64_t want = (hist->count * p + 99) / 100;
+    uint64_t seen = 0;
+
+    for(uint32_t i = 0; i < STATS_BUCKETS; i++) {
+        seen += hist->buckets[i];
+        if(seen >= want) {
+            return (uint64_t) 1 << i;
+        }
+    }
+
+    return (uint64_t) 1 << (STATS_BUCKETS - 1);
+}
+
+static void hist_print(FILE* out, const char* name, const struct stats_hist* hist, uint64_t roundtrips) {
+    fprintf(out, "%-18s count %llu mean_us %.1f p50_us %llu p99_us %llu max_us %.1f roundtrips %llu\n",
+            name, (unsigned long long) hist->count,
+            (double) hist->total_ns / hist->count / 1000.0,
+            (unsigned long long) hist_percentile(hist, 50),
+            (unsigned long long) hist_percentile(hist, 99),
+            (double) hist->max_ns / 1000.0,
+            (unsigned long long) roundtrips);
+}
+
+void stats_end_event(uint8_t type, struct stats_mark mark) {
+    type &= STATS_EVENT_TYPES - 1;
+
+    stats.events++;
+    hist_add(&stats.event_hist[type], stats_now() - mark.ns);
+    stats.event_roundtrips[type] += stats.roundtrips - mark.roundtrips;
+}
+
+void stats_end_batch(struct stats_mark mark) {
+    stats.batches++;
+    hist_add(&stats.batch_hist, stats_now() - mark.ns);
+    stats.batch_roundtrips += stats.roundtrips - mark.roundtrips;
+}
+
+void stats_flush(xcb_connection_t* dpy) {
+    uint64_t written = xcb_total_written(dpy);
+
+    xcb_flush(dpy);
+    // Only count flushes that actually had to write something
+    if(xcb_total_written(dpy) != written) {
+        stats.flushes++;
+    }
+}
+
+void stats_print(FILE* out, xcb_connection_t* dpy) {
+    uint64_t requests;
+    double events = stats.events ? (double) stats.events : 1.0;
+
+    // Sequence numbers count every request sent on the connection. The
+    // probe itself doesn't need to go out until the next flush.
+    requests = xcb_no_operation(dpy).sequence - ++stats.probes;
+
+    fprintf(out, "events %llu\n", (unsigned long long) stats.events);
+    fprintf(out, "batches %llu\n", (unsigned long long) stats.batches);
+    fprintf(out, "flushes %llu (%.3f per event)\n", (unsigned long long) stats.flushes, stats.flushes / events);
+    fprintf(out, "requests %llu (%.3f per event)\n", (unsigned long long) requests, requests / events);
+    fprintf(out, "roundtrips %llu (%.3f per event)\n", (unsigned long long) stats.roundtrips, stats.roundtrips / events);
+    fprintf(out, "crossings_ignored %llu\n", (unsigned long long) stats.crossings_ignored);
+    fprintf(out, "bytes_written %llu\n", (unsigned long long) xcb_total_written(dpy));
+    for(uint32_t i = 0; i < STATS_MEM_KINDS; i++) {
+        const struct stats_mem* mem = &stats.mem[i];
+
+        fprintf(out, "mem_%s live %llu peak %llu allocs %llu frees %llu\n", mem_names[i],
+                (unsigned long long) (mem->allocs - mem->frees),
+                (unsigned long long) mem->peak,
+                (unsigned long long) mem->allocs,
+                (unsigned long long) mem->frees);
+    }
+    // Everything else malloc()ed, and what the kernel charges us for
+    fprintf(out, "heap_bytes %zu\n", mallinfo2().uordblks);
+    fprintf(out, "rss_kb %llu\n", (unsigned long long) rss_kb());
+    for(uint32_t i = 0; i < STATS_EVENT_TYPES; i++) {
+        char name[32];
+
+        if(stats.event_hist[i].count == 0) {
+            continue;
+        }
+        if(i < sizeof(event_names) / sizeof(event_names[0]) && event_names[i]) {
+            snprintf(name, sizeof(name), "%s", event_names[i]);
+        } else {
+            snprintf(name, sizeof(name), "event_%u", i);
+        }
+        hist_print(out, name, &stats.event_hist[i], stats.event_roundtrips[i]);
+    }
+    if(stats.batch_hist.count) {
+        hist_print(out, "batch", &stats.batch_hist, stats.batch_roundtrips);
+    }
+}
@@ -0,0 +1,155 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <xcb/xcb.h>
+
+/*
+ * Counters for what the event loop costs us.
+ */
+
+/* Latency buckets: bucket i holds times under 2^i microseconds */
+#define STATS_BUCKETS 24
+
+/* Core event types fit in the low 7 bits of response_type */
+#define STATS_EVENT_TYPES 128
+
+/*
+ * What we keep allocations apart by. Events and replies are what XCB
+ * hands us and we free; clients are our client records, their property
+ * cache entries and the strings in those.
+ */
+enum stats_mem_kind {
+    STATS_MEM_EVENTS,
+    STATS_MEM_REPLIES,
+    STATS_MEM_CLIENTS,
+    STATS_MEM_KINDS
+};
+
+struct stats_mem {
+    uint64_t allocs;
+    uint64_t frees;
+    /* Most ever live at once */
+    uint64_t peak;
+};
+
+struct stats_hist {
+    uint64_t count;
+    uint64_t total_ns;
+    uint64_t max_ns;
+    uint64_t buckets[STATS_BUCKETS];
+};
+
+struct stats {
+    /* Events handled */
+    uint64_t events;
+    /* Times the loop woke up and drained the event queue */
+    uint64_t batches;
+    /* Times we flushed a non-empty output buffer to the server */
+    uint64_t flushes;
+    /* Times we blocked waiting for replies */
+    uint64_t roundtrips;
+    /* Requests made only to find out how many requests we made */
+    uint64_t probes;
+    /* Enter/LeaveNotifies that our own requests caused, ignored */
+    uint64_t crossings_ignored;
+
+    /* Time spent in the handler, per event type */
+    struct stats_hist event_hist[STATS_EVENT_TYPES];
+    /* Round trips made from inside the handler, per event type */
+    uint64_t event_roundtrips[STATS_EVENT_TYPES];
+    /* Time spent after draining a batch: replies, drag, flush */
+    struct stats_hist batch_hist;
+    /* Round trips made after draining a batch */
+    uint64_t batch_roundtrips;
+
+    /* Allocations made and given back, per stats_mem_kind */
+    struct stats_mem mem[STATS_MEM_KINDS];
+};
+
+extern struct stats stats;
+
+/*
+ * Where a measurement started.
+ */
+struct stats_mark {
+    uint64_t ns;
+    uint64_t roundtrips;
+};
+
+static inline uint64_t stats_now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + (uint64_t) ts.tv_nsec;
+}
+
+static inline struct stats_mark stats_begin(void) {
+    struct stats_mark mark = { stats_now(), stats.roundtrips };
+
+    return mark;
+}
+
+/*
+ * Account an allocation of kind, and giving one back.
+ */
+static inline void stats_alloc(enum stats_mem_kind kind) {
+    struct stats_mem* mem = &stats.mem[kind];
+
+    mem->allocs++;
+    if(mem->allocs - mem->frees > mem->peak) {
+        mem->peak = mem->allocs - mem->frees;
+    }
+}
+
+static inline void stats_free(enum stats_mem_kind kind) {
+    stats.mem[kind].frees++;
+}
+
+/*
+ * Account reply (or error), as it comes from XCB, and return it. NULL
+ * is passed through.
+ */
+static inline void* stats_reply(void* reply) {
+    if(reply != NULL) {
+        stats_alloc(STATS_MEM_REPLIES);
+    }
+    return reply;
+}
+
+/*
+ * Free a reply from stats_reply(). reply may be NULL.
+ */
+static inline void stats_reply_free(void* reply) {
+    if(reply != NULL) {
+        free(reply);
+        stats_free(STATS_MEM_REPLIES);
+    }
+}
+
+/*
+ * Account an event of type, handled since mark.
+ */
+void stats_end_event(uint8_t type, struct stats_mark mark);
+
+/*
+ * Account the end-of-batch work done since mark.
+ */
+void stats_end_batch(struct stats_mark mark);
+
+/*
+ * Flush the output buffer, counting it if there was anything to send.
+ */
+void stats_flush(xcb_connection_t* dpy);
+
+/*
+ * Print all counters to out, and how much memory the process has.
+ * Sends one request to learn how many we have sent so far.
+ */
+void stats_print(FILE* out, xcb_connection_t* dpy);
+
+#endif /* STATS_H */
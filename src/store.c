@@ -0,0 +1,142 @@
+#include <stdlib.h>
+
+#include "store.h"
+
+#define STORE_MAX_SLOTS 0xFFFFFF
+
+static bool store_grow(struct store* store) {
+    uint32_t cap = store->cap ? store->cap * 2 : 64;
+
+#define STORE_REALLOC(field) do { \
+        void* p = realloc(store->field, cap * sizeof(*store->field)); \
+        if(p == NULL) { \
+            return false; \
+        } \
+        store->field = p; \
+    } while(0)
+
+    // The slot arrays never hold more entries than the dense ones
+    STORE_REALLOC(ids);
+    STORE_REALLOC(x);
+    STORE_REALLOC(y);
+    STORE_REALLOC(w);
+    STORE_REALLOC(h);
+    STORE_REALLOC(border);
+    STORE_REALLOC(flags);
+    STORE_REALLOC(owners);
+    STORE_REALLOC(slots);
+    STORE_REALLOC(gens);
+
+#undef STORE_REALLOC
+
+    store->cap = cap;
+
+    return true;
+}
+
+store_handle_t store_add(struct store* store, xcb_window_t window,
+                         int16_t x, int16_t y, uint16_t w, uint16_t h) {
+    uint32_t slot;
+    uint32_t i;
+
+    if(store->len == store->cap && !store_grow(store)) {
+        return STORE_NONE;
+    }
+
+    if(store->free_slot != UINT32_MAX) {
+        slot = store->free_slot;
+        store->free_slot = store->slots[slot];
+    } else {
+        if(store->nslots == STORE_MAX_SLOTS) {
+            return STORE_NONE;
+        }
+        slot = store->nslots++;
+        store->gens[slot] = 1;
+    }
+
+    i = store->len++;
+    store->slots[slot] = i;
+    store->owners[i] = slot;
+    store->ids[i] = window;
+    store->flags[i] = 0;
+    store->border[i] = 0;
+    store_set_geom(store, i, x, y, w, h);
+
+    return ((uint32_t) store->gens[slot] << 24) | slot;
+}
+
+void store_remove(struct store* store, store_handle_t handle) {
+    int32_t i = store_index(store, handle);
+    uint32_t slot = handle & 0xFFFFFF;
+    uint32_t last;
+
+    if(i < 0) {
+        return;
+    }
+
+    // Fill the hole with the last entry
+    last = --store->len;
+    if((uint32_t) i != last) {
+        store->ids[i] = store->ids[last];
+        store->x[i] = store->x[last];
+        store->y[i] = store->y[last];
+        store->w[i] = store->w[last];
+        store->h[i] = store->h[last];
+        store->border[i] = store->border[last];
+        store->flags[i] = store->flags[last];
+        store->owners[i] = store->owners[last];
+        store->slots[store->owners[i]] = (uint32_t) i;
+    }
+
+    // Stale handles must never match again. Generation 0 is skipped so
+    // no handle is ever STORE_NONE.
+    store->gens[slot] = store->gens[slot] == 0xFF ? 1 : store->gens[slot] + 1;
+    store->slots[slot] = store->free_slot;
+    store->free_slot = slot;
+}
+
+int32_t store_at(const struct store* store, int16_t px, int16_t py) {
+    // Any hit will do; see store.h. No short-circuiting inside the
+    // test keeps it to a single branch.
+    for(int32_t i = (int32_t) store->len - 1; i >= 0; i--) {
+        int32_t inside = ((uint32_t) (px - store->x[i]) < store->w[i])
+                         & ((uint32_t) (py - store->y[i]) < store->h[i]);
+
+        if(inside) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+uint32_t store_count_overlapping(const struct store* store, xcb_rectangle_t rect) {
+    int32_t rx2 = rect.x + rect.width;
+    int32_t ry2 = rect.y + rect.height;
+    uint32_t n = 0;
+
+    // Branch-free, so it vectorises
+    for(uint32_t i = 0; i < store->len; i++) {
+        int32_t x = store->x[i];
+        int32_t y = store->y[i];
+
+        n += (x < rx2) & (rect.x < x + store->w[i])
+             & (y < ry2) & (rect.y < y + store->h[i]);
+    }
+
+    return n;
+}
+
+void store_free(struct store* store) {
+    free(store->ids);
+    free(store->x);
+    free(store->y);
+    free(store->w);
+    free(store->h);
+    free(store->border);
+    free(store->flags);
+    free(store->owners);
+    free(store->slots);
+    free(store->gens);
+    *store = (struct store) STORE_INIT;
+}
@@ -0,0 +1,123 @@
+#ifndef STORE_H
+#define STORE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <xcb/xproto.h>
+
+/*
+ * Client store: what we know about every managed window, kept as
+ * parallel dense arrays instead of one struct per window.
+ *
+ * Entry i of ids, x, y, w, h, border and flags all belong to the same
+ * window, and the first len entries are live. Removing an entry moves
+ * the last one into its place, so the arrays never have holes and a
+ * loop over all windows is a straight walk over contiguous memory.
+ *
+ * Because entries move, hang on to windows through handles, not
+ * indices. A handle stays valid until its entry is removed, and using
+ * it afterwards is caught rather than hitting some other window.
+ */
+
+/* Slot in the low 24 bits, generation in the high 8. Never 0. */
+typedef uint32_t store_handle_t;
+
+#define STORE_NONE 0
+
+struct store {
+    /* Dense arrays, len entries each */
+    xcb_window_t* ids;
+    int16_t* x;
+    int16_t* y;
+    uint16_t* w;
+    uint16_t* h;
+    uint16_t* border;
+    uint32_t* flags;
+    /* Slot that points at each dense entry */
+    uint32_t* owners;
+    uint32_t len;
+    uint32_t cap;
+
+    /* Slot -> dense index for live slots, next free slot otherwise */
+    uint32_t* slots;
+    /* Generation of each slot, bumped when it's freed */
+    uint8_t* gens;
+    uint32_t nslots;
+    uint32_t free_slot;
+};
+
+#define STORE_INIT { NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, 0, 0, NULL, NULL, 0, UINT32_MAX }
+
+/*
+ * Add an entry for window. Returns its handle, or STORE_NONE if out of
+ * memory.
+ */
+store_handle_t store_add(struct store* store, xcb_window_t window,
+                         int16_t x, int16_t y, uint16_t w, uint16_t h);
+
+/*
+ * Remove the entry for handle. Invalidates handle, and the dense index
+ * of the entry that was last.
+ */
+void store_remove(struct store* store, store_handle_t handle);
+
+/*
+ * Dense index of handle, or -1 if the handle is stale.
+ */
+static inline int32_t store_index(const struct store* store, store_handle_t handle) {
+    uint32_t slot = handle & 0xFFFFFF;
+
+    if(handle == STORE_NONE || slot >= store->nslots || store->gens[slot] != handle >> 24) {
+        return -1;
+    }
+
+    return (int32_t) store->slots[slot];
+}
+
+/*
+ * Handle of the entry at dense index i.
+ */
+static inline store_handle_t store_handle(const struct store* store, uint32_t i) {
+    uint32_t slot = store->owners[i];
+
+    return ((uint32_t) store->gens[slot] << 24) | slot;
+}
+
+/*
+ * Set the geometry of entry i.
+ */
+static inline void store_set_geom(struct store* store, uint32_t i,
+                                  int16_t x, int16_t y, uint16_t w, uint16_t h) {
+    store->x[i] = x;
+    store->y[i] = y;
+    store->w[i] = w;
+    store->h[i] = h;
+}
+
+/*
+ * Set the border width of entry i.
+ */
+static inline void store_set_border(struct store* store, uint32_t i, uint16_t border) {
+    store->border[i] = border;
+}
+
+/*
+ * Dense index of an entry whose rectangle holds the point (px, py), or
+ * -1 if there is none. It's the one with the highest dense index, but
+ * store_remove() moves entries around, so that says nothing about
+ * which window is on top; ask the stacking order for that.
+ */
+int32_t store_at(const struct store* store, int16_t px, int16_t py);
+
+/*
+ * Count the entries whose rectangle overlaps rect.
+ */
+uint32_t store_count_overlapping(const struct store* store, xcb_rectangle_t rect);
+
+/*
+ * Free all arrays. Every handle becomes stale.
+ */
+void store_free(struct store* store);
+
+#endif /* STORE_H */
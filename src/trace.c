@@ -0,0 +1,87 @@
+#include <string.h>
+
+#include "stats.h"
+#include "trace.h"
+
+/* How long buffered records may sit before trace_sync() writes them */
+#define TRACE_SYNC_NS 250000000
+
+bool trace_create(struct trace* trace, const char* path) {
+    // Not handed down to a restart
+    trace->file = fopen(path, "wbe");
+    if(trace->file == NULL) {
+        return false;
+    }
+    // Let stdio batch up records; trace_sync() bounds how stale they get
+    setvbuf(trace->file, NULL, _IOFBF, 1 << 16);
+
+    trace->start_ns = stats_now();
+    trace->synced_ns = trace->start_ns;
+    trace->started = false;
+
+    if(fwrite(TRACE_MAGIC, strlen(TRACE_MAGIC), 1, trace->file) != 1) {
+        fclose(trace->file);
+        trace->file = NULL;
+        return false;
+    }
+
+    return true;
+}
+
+bool trace_open(struct trace* trace, const char* path) {
+    char magic[sizeof(TRACE_MAGIC)] = { 0 };
+
+    trace->file = fopen(path, "rb");
+    if(trace->file == NULL) {
+        return false;
+    }
+    trace->start_ns = 0;
+    trace->synced_ns = 0;
+    trace->started = false;
+
+    if(fread(magic, strlen(TRACE_MAGIC), 1, trace->file) != 1 || strcmp(magic, TRACE_MAGIC) != 0) {
+        fclose(trace->file);
+        trace->file = NULL;
+        return false;
+    }
+
+    return true;
+}
+
+void trace_write(struct trace* trace, const xcb_generic_event_t* ev, uint32_t batch, uint8_t flags) {
+    struct trace_record record;
+
+    if(!trace->started) {
+        trace->start_sequence = ev->full_sequence;
+        trace->started = true;
+    }
+    memset(&record, 0, sizeof(record));
+    record.ns = stats_now() - trace->start_ns;
+    record.batch = batch;
+    record.sequence = ev->full_sequence - trace->start_sequence;
+    record.type = ev->response_type;
+    record.flags = flags;
+    memcpy(record.event, ev, TRACE_EVENT_SIZE);
+
+    fwrite(&record, sizeof(record), 1, trace->file);
+}
+
+void trace_sync(struct trace* trace) {
+    uint64_t now = stats_now();
+
+    if(now - trace->synced_ns >= TRACE_SYNC_NS) {
+        fflush(trace->file);
+        trace->synced_ns = now;
+    }
+}
+
+bool trace_read(struct trace* trace, struct trace_record* record) {
+    return fread(record, sizeof(*record), 1, trace->file) == 1;
+}
+
+void trace_close(struct trace* trace) {
+    if(trace->file) {
+        fclose(trace->file);
+        trace->file = NULL;
+    }
+}
@@ -0,0 +1,90 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <xcb/xcb.h>
+
+/*
+ * Event traces.
+ *
+ * A trace is every event the main loop handled, in order, as it came
+ * off the wire. Feeding one back through the same handlers reproduces
+ * the session's work without the user in front of it.
+ *
+ * File layout: TRACE_MAGIC, then one struct trace_record per event.
+ * All fields are host byte order; traces aren't meant to travel.
+ */
+
+#define TRACE_MAGIC "QTWMTRC2"
+
+/* Core events are always 32 bytes on the wire */
+#define TRACE_EVENT_SIZE 32
+
+struct trace_record {
+    /* Nanoseconds since the trace started */
+    uint64_t ns;
+    /* Which batch of the event loop the event was handled in */
+    uint32_t batch;
+    /* full_sequence of the event, counted from the first one's. It
+     * isn't in the 32 bytes on the wire. */
+    uint32_t sequence;
+    /* response_type of the event, repeated for easy filtering */
+    uint8_t type;
+    /* TRACE_OURS and such */
+    uint8_t flags;
+    uint8_t pad[2];
+    uint8_t event[TRACE_EVENT_SIZE];
+};
+
+/* The event was caused by one of the window manager's own requests.
+ * Sequence numbers can't tell on replay: the requests made then aren't
+ * the ones made while recording. */
+#define TRACE_OURS (1 << 0)
+
+struct trace {
+    FILE* file;
+    uint64_t start_ns;
+    /* When the file was last flushed */
+    uint64_t synced_ns;
+    /* full_sequence of the first event written, and whether there was
+     * one yet */
+    uint32_t start_sequence;
+    bool started;
+};
+
+/*
+ * Start writing a new trace to path. Returns false on error.
+ */
+bool trace_create(struct trace* trace, const char* path);
+
+/*
+ * Open the trace at path for reading. Returns false on error, or if it
+ * isn't a trace.
+ */
+bool trace_open(struct trace* trace, const char* path);
+
+/*
+ * Append ev, handled in batch, with flags.
+ */
+void trace_write(struct trace* trace, const xcb_generic_event_t* ev, uint32_t batch, uint8_t flags);
+
+/*
+ * Push buffered records out to the file, at most every few hundred
+ * milliseconds so recording doesn't cost a write per batch.
+ */
+void trace_sync(struct trace* trace);
+
+/*
+ * Read the next record. Returns false at the end of the trace.
+ */
+bool trace_read(struct trace* trace, struct trace_record* record);
+
+/*
+ * Flush and close.
+ */
+void trace_close(struct trace* trace);
+
+#endif /* TRACE_H */
@@ -0,0 +1,159 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "wintable.h"
+
+/* Smallest table we bother allocating */
+#define WINTABLE_MIN_BITS 5
+
+/*
+ * Window IDs are handed out sequentially from a per-client resource
+ * base, so the low bits are dense and the high bits are nearly
+ * constant. Fibonacci hashing spreads both across the table.
+ */
+static inline uint32_t wintable_hash(const struct wintable* table, xcb_window_t window) {
+    return (uint32_t) (window * 2654435769u) >> (32 - table->bits);
+}
+
+/* Keep the load factor under 3/4 */
+static inline bool wintable_too_full(uint32_t count, uint32_t size) {
+    return (uint64_t) count * 4 >= (uint64_t) size * 3;
+}
+
+static void wintable_insert(struct wintable* table, xcb_window_t window, void* value) {
+    uint32_t mask = table->size - 1;
+    uint32_t i = wintable_hash(table, window);
+
+    while(table->slots[i].key != XCB_NONE && table->slots[i].key != window) {
+        i = (i + 1) & mask;
+    }
+    if(table->slots[i].key == XCB_NONE) {
+        table->count++;
+    }
+    table->slots[i].key = window;
+    table->slots[i].value = value;
+}
+
+static bool wintable_rehash(struct wintable* table, uint32_t bits) {
+    struct wintable old = *table;
+    struct wintable_slot* slots;
+
+    slots = calloc((size_t) 1 << bits, sizeof(struct wintable_slot));
+    if(slots == NULL) {
+        return false;
+    }
+
+    table->slots = slots;
+    table->size = (uint32_t) 1 << bits;
+    table->bits = bits;
+    table->count = 0;
+
+    for(uint32_t i = 0; i < old.size; i++) {
+        if(old.slots[i].key != XCB_NONE) {
+            wintable_insert(table, old.slots[i].key, old.slots[i].value);
+        }
+    }
+    free(old.slots);
+
+    return true;
+}
+
+bool wintable_reserve(struct wintable* table, uint32_t n) {
+    uint32_t bits = table->bits < WINTABLE_MIN_BITS ? WINTABLE_MIN_BITS : table->bits;
+
+    while(wintable_too_full(n, (uint32_t) 1 << bits)) {
+        bits++;
+    }
+    if(table->slots != NULL && bits == table->bits) {
+        return true;
+    }
+
+    return wintable_rehash(table, bits);
+}
+
+void* wintable_get(const struct wintable* table, xcb_window_t window) {
+    uint32_t mask;
+    uint32_t i;
+
+    if(table->count == 0 || window == XCB_NONE) {
+        return NULL;
+    }
+
+    mask = table->size - 1;
+    for(i = wintable_hash(table, window); table->slots[i].key != XCB_NONE; i = (i + 1) & mask) {
+        if(table->slots[i].key == window) {
+            return table->slots[i].value;
+        }
+    }
+
+    return NULL;
+}
+
+bool wintable_put(struct wintable* table, xcb_window_t window, void* value) {
+    if(window == XCB_NONE) {
+        return false;
+    }
+    if(table->slots == NULL || wintable_too_full(table->count + 1, table->size)) {
+        if(!wintable_reserve(table, table->count + 1)) {
+            return false;
+        }
+    }
+
+    wintable_insert(table, window, value);
+
+    return true;
+}
+
+void* wintable_del(struct wintable* table, xcb_window_t window) {
+    uint32_t mask;
+    uint32_t i;
+    uint32_t j;
+    void* value;
+
+    if(table->count == 0 || window == XCB_NONE) {
+        return NULL;
+    }
+
+    mask = table->size - 1;
+    for(i = wintable_hash(table, window); table->slots[i].key != window; i = (i + 1) & mask) {
+        if(table->slots[i].key == XCB_NONE) {
+            return NULL;
+        }
+    }
+
+    value = table->slots[i].value;
+    table->count--;
+
+    /*
+     * Backward-shift: pull every following entry of the probe run into
+     * the hole if that doesn't move it in front of its home slot.
+     */
+    for(j = (i + 1) & mask; table->slots[j].key != XCB_NONE; j = (j + 1) & mask) {
+        uint32_t home = wintable_hash(table, table->slots[j].key);
+
+        if(((j - home) & mask) >= ((j - i) & mask)) {
+            table->slots[i] = table->slots[j];
+            i = j;
+        }
+    }
+    table->slots[i].key = XCB_NONE;
+    table->slots[i].value = NULL;
+
+    return value;
+}
+
+void wintable_clear(struct wintable* table) {
+    if(table->count == 0) {
+        return;
+    }
+    memset(table->slots, 0, table->size * sizeof(struct wintable_slot));
+    table->count = 0;
+}
+
+void wintable_free(struct wintable* table) {
+    free(table->slots);
+    table->slots = NULL;
+    table->size = 0;
+    table->bits = 0;
+    table->count = 0;
+}
@@ -0,0 +1,69 @@
+#ifndef WINTABLE_H
+#define WINTABLE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <xcb/xproto.h>
+
+/*
+ * Open-addressing hash index from window IDs to arbitrary data.
+ *
+ * Linear probing with backward-shift deletion, so there are no
+ * tombstones and lookups never degrade with churn. XCB_NONE is never
+ * a valid window and marks an empty slot.
+ */
+
+struct wintable_slot {
+    xcb_window_t key;
+    void* value;
+};
+
+struct wintable {
+    struct wintable_slot* slots;
+    /* Number of slots, always a power of two (or 0) */
+    uint32_t size;
+    /* log2(size), for the multiplicative hash */
+    uint32_t bits;
+    /* Number of occupied slots */
+    uint32_t count;
+};
+
+#define WINTABLE_INIT { NULL, 0, 0, 0 }
+
+/*
+ * Make room for at least n entries without rehashing.
+ *
+ * Returns false if out of memory. The table is left untouched then.
+ */
+bool wintable_reserve(struct wintable* table, uint32_t n);
+
+/*
+ * Find the data stored for window, or NULL if there is none.
+ */
+void* wintable_get(const struct wintable* table, xcb_window_t window);
+
+/*
+ * Store value for window, replacing whatever was there before.
+ *
+ * Returns false if out of memory.
+ */
+bool wintable_put(struct wintable* table, xcb_window_t window, void* value);
+
+/*
+ * Remove window from the table. Returns the data that was stored for
+ * it, or NULL if there was none.
+ */
+void* wintable_del(struct wintable* table, xcb_window_t window);
+
+/*
+ * Remove every entry, keeping the slots for reuse.
+ */
+void wintable_clear(struct wintable* table);
+
+/*
+ * Free all slots. Does not touch the stored data.
+ */
+void wintable_free(struct wintable* table);
+
+#endif /* WINTABLE_H */
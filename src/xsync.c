@@ -0,0 +1,109 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "atoms.h"
+#include "config.h"
+#include "stats.h"
+#include "xsync.h"
+
+#ifdef XSYNC
+#include <xcb/sync.h>
+#endif
+
+void xsync_init(struct xsync* xsync, xcb_connection_t* dpy) {
+#ifdef XSYNC
+    const xcb_query_extension_reply_t* ext = xcb_get_extension_data(dpy, &xcb_sync_id);
+    xcb_sync_initialize_reply_t* reply;
+
+    if(ext == NULL || !ext->present) {
+        return;
+    }
+    // The server won't take any other Sync request before this one
+    reply = stats_reply(xcb_sync_initialize_reply(dpy, xcb_sync_initialize(dpy, XCB_SYNC_MAJOR_VERSION,
+                                                  XCB_SYNC_MINOR_VERSION), NULL));
+    stats.roundtrips++;
+    if(reply == NULL) {
+        return;
+    }
+    stats_reply_free(reply);
+    xsync->event_base = ext->first_event;
+#endif
+}
+
+bool xsync_watch(struct xsync* xsync, xcb_connection_t* dpy, uint32_t counter) {
+#ifdef XSYNC
+    // Counter, value type, test type, events. The value comes with the
+    // first request.
+    uint32_t values[4] = {
+        counter,
+        XCB_SYNC_VALUETYPE_ABSOLUTE,
+        XCB_SYNC_TESTTYPE_POSITIVE_COMPARISON,
+        1
+    };
+
+    if(xsync->event_base == 0 || counter == XCB_NONE) {
+        return false;
+    }
+    xsync_unwatch(xsync, dpy);
+    xsync->alarm = xcb_generate_id(dpy);
+    xcb_sync_create_alarm(dpy, xsync->alarm, XCB_SYNC_CA_COUNTER | XCB_SYNC_CA_VALUE_TYPE
+                          | XCB_SYNC_CA_TEST_TYPE | XCB_SYNC_CA_EVENTS, values);
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+void xsync_request(struct xsync* xsync, xcb_connection_t* dpy, xcb_window_t window, uint64_t value) {
+#ifdef XSYNC
+    xcb_client_message_event_t ev;
+    // Sync's 64-bit values go high half first
+    uint32_t values[2] = { (uint32_t) (value >> 32), (uint32_t) value };
+
+    if(xsync->alarm == XCB_NONE) {
+        return;
+    }
+    // Changing the value rearms the alarm, even if it already went off
+    xcb_sync_change_alarm(dpy, xsync->alarm, XCB_SYNC_CA_VALUE, values);
+
+    memset(&ev, 0, sizeof(ev));
+    ev.response_type = XCB_CLIENT_MESSAGE;
+    ev.format = 32;
+    ev.window = window;
+    ev.type = atoms[ATOM_WM_PROTOCOLS];
+    ev.data.data32[0] = atoms[ATOM__NET_WM_SYNC_REQUEST];
+    ev.data.data32[1] = XCB_CURRENT_TIME;
+    ev.data.data32[2] = (uint32_t) value;
+    ev.data.data32[3] = (uint32_t) (value >> 32);
+    xcb_send_event(dpy, 0, window, XCB_EVENT_MASK_NO_EVENT, (const char*) &ev);
+#endif
+}
+
+bool xsync_event(struct xsync* xsync, const xcb_generic_event_t* ev, uint64_t* value) {
+#ifdef XSYNC
+    const xcb_sync_alarm_notify_event_t* e = (const xcb_sync_alarm_notify_event_t*) ev;
+
+    if(xsync->event_base == 0 || (ev->response_type & ~0x80) != xsync->event_base + XCB_SYNC_ALARM_NOTIFY) {
+        return false;
+    }
+    // Left over from an alarm we've since destroyed
+    if(xsync->alarm == XCB_NONE || e->alarm != xsync->alarm) {
+        return false;
+    }
+    *value = (uint64_t) (uint32_t) e->counter_value.hi << 32 | e->counter_value.lo;
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+void xsync_unwatch(struct xsync* xsync, xcb_connection_t* dpy) {
+#ifdef XSYNC
+    if(xsync->alarm != XCB_NONE) {
+        xcb_sync_destroy_alarm(dpy, xsync->alarm);
+        xsync->alarm = XCB_NONE;
+    }
+#endif
+}
@@ -0,0 +1,59 @@
+#ifndef XSYNC_H
+#define XSYNC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <xcb/xcb.h>
+
+/*
+ * _NET_WM_SYNC_REQUEST, for pacing interactive resizes.
+ *
+ * A client that speaks the protocol keeps a Sync counter, and sets it
+ * to the value we ask for once it has handled the ConfigureNotify that
+ * followed the request and redrawn. An alarm on that counter tells us
+ * when that happened, so the next size goes out only once the client
+ * caught up with the last one, instead of piling up behind it.
+ *
+ * Only one window is resized at a time, so there is only ever one
+ * alarm.
+ */
+
+struct xsync {
+    /* First Sync event code, or 0 if we don't have Sync */
+    uint8_t event_base;
+    /* Alarm on the counter of the window being resized, or XCB_NONE */
+    uint32_t alarm;
+};
+
+#define XSYNC_INIT { 0, XCB_NONE }
+
+/*
+ * Set up the Sync extension, if the server has it. One round trip.
+ */
+void xsync_init(struct xsync* xsync, xcb_connection_t* dpy);
+
+/*
+ * Watch counter, the _NET_WM_SYNC_REQUEST_COUNTER of the window about
+ * to be resized. Returns false if we can't, and the resize has to be
+ * paced some other way.
+ */
+bool xsync_watch(struct xsync* xsync, xcb_connection_t* dpy, uint32_t counter);
+
+/*
+ * Ask window to set its counter to value once it has handled the
+ * resize sent right after this, and raise the alarm when it does.
+ */
+void xsync_request(struct xsync* xsync, xcb_connection_t* dpy, xcb_window_t window, uint64_t value);
+
+/*
+ * Is ev our alarm going off? If so, value gets the counter's value.
+ */
+bool xsync_event(struct xsync* xsync, const xcb_generic_event_t* ev, uint64_t* value);
+
+/*
+ * Stop watching. The resize is over.
+ */
+void xsync_unwatch(struct xsync* xsync, xcb_connection_t* dpy);
+
+#endif /* XSYNC_H */